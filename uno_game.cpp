@@ -1,4 +1,11 @@
-﻿#include <opencv2/opencv.hpp>
+﻿#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#include <opencv2/opencv.hpp>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -6,6 +13,42 @@
 #include <ctime>
 #include <algorithm>
 #include <queue>
+#include <sstream>
+#include <cstdint>
+#include <cmath>
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+#include <deque>
+#include <condition_variable>
+#if defined(_M_X64) || defined(__x86_64__)
+#define UNO_AVX2_KERNEL // 编译AVX2打分内核，运行时按CPU选择
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
 
 using namespace cv;
 using namespace std;
@@ -300,6 +343,98 @@ public:
     }
 };
 
+// 电脑出牌的权重表
+struct HeuristicWeights {
+    int wildDrawFour = 5;
+    int drawTwo = 4;
+    int skip = 3;
+    int reverse = 3;
+    int wildColor = 2;
+    int colorMatch = 1; // 与顶牌同色时的加分
+
+    // 计算一张牌的出牌价值，数字牌取牌面数字
+    int cardValue(UnoCard::Type type, UnoCard::Color color, int number, UnoCard::Color topColor) const {
+        int value = 0;
+        switch (type) {
+        case UnoCard::WILD_DRAW_FOUR: value = wildDrawFour; break;
+        case UnoCard::DRAW_TWO: value = drawTwo; break;
+        case UnoCard::SKIP: value = skip; break;
+        case UnoCard::REVERSE: value = reverse; break;
+        case UnoCard::WILD_COLOR: value = wildColor; break;
+        default: value = number; break;
+        }
+
+        // 尝试匹配当前颜色
+        if (color == topColor) {
+            value += colorMatch;
+        }
+        return value;
+    }
+
+    // 从"5,4,3,3,2,1"格式的字符串解析权重表
+    static HeuristicWeights parse(const string& text) {
+        HeuristicWeights weights;
+        int* fields[] = { &weights.wildDrawFour, &weights.drawTwo, &weights.skip,
+                          &weights.reverse, &weights.wildColor, &weights.colorMatch };
+        stringstream ss(text);
+        string item;
+        try {
+            for (int i = 0; i < 6 && getline(ss, item, ','); i++) {
+                *fields[i] = stoi(item);
+            }
+        }
+        catch (const logic_error&) {
+            throw runtime_error("权重应为逗号分隔的整数: " + text);
+        }
+        return weights;
+    }
+
+    string toString() const {
+        return to_string(wildDrawFour) + "," + to_string(drawTwo) + "," + to_string(skip) + "," +
+               to_string(reverse) + "," + to_string(wildColor) + "," + to_string(colorMatch);
+    }
+};
+
+class UnoGame;
+
+// 对局进展的监听（例如观战广播），开局和每个回合结束时调用
+class UnoGameListener {
+public:
+    virtual ~UnoGameListener() {}
+    virtual void onTurnEnd(const UnoGame& game) = 0;
+};
+
+// 电脑玩家的决策，开局后会收到牌桌上所有公开的事件，可以据此推测对手手牌
+class UnoComputerBrain {
+public:
+    virtual ~UnoComputerBrain() {}
+    virtual void beginGame(const UnoGame& game) = 0;
+    virtual void onCardPlayed(int seat, const UnoCard& card) = 0;
+    // 每个座位只能看到自己抽到的牌，实现时不能让其他座位的决策用到card
+    virtual void onCardDrawn(int seat, const UnoCard& card) = 0;
+    // 没有可打的牌，被迫抽牌
+    virtual void onForcedDraw(int seat, const UnoCard& topCard) = 0;
+    // 抽到的牌打不出，跳过回合
+    virtual void onPass(int seat) = 0;
+    virtual void onReshuffle() = 0;
+    // 为当前电脑玩家选一张可打的牌，返回手牌索引
+    virtual int chooseCard(const UnoGame& game, const vector<int>& playableIndices) = 0;
+    // 为当前电脑玩家刚打出的野生牌选颜色
+    virtual UnoCard::Color chooseColor(const UnoGame& game, UnoCard::Type playedType) = 0;
+};
+
+// 玩家回合的出牌参考：在后台估计每个选择的胜率
+class UnoMoveAdvisor {
+public:
+    virtual ~UnoMoveAdvisor() {}
+    // 玩家回合开始，开始分析当前局面
+    virtual void startAnalysis(const UnoGame& game) = 0;
+    // 玩家已经做出选择，取消分析
+    virtual void stopAnalysis() = 0;
+    // 当前的估计：winRates按手牌索引，不能打的牌为-1，最后一项是抽牌；返回已完成的模拟次数（0表示没有估计）
+    virtual int getEstimates(vector<double>& winRates) const = 0;
+};
+
 // UNO游戏类
 class UnoGame {
 private:
@@ -309,9 +444,80 @@ private:
     int currentPlayerIndex;
     bool gameOver;
     bool clockwise; // 游戏方向：顺时针或逆时针
+    HeuristicWeights computerWeights; // 电脑出牌权重
+    int cardsPlayed; // 已打出的牌数
+    UnoGameListener* listener;
+    UnoMoveAdvisor* advisor; // 出牌参考，可以为空
+    UnoComputerBrain* brain; // 电脑玩家的决策，为空时使用computerWeights和随机选色
+
+    void notifyListener() {
+        if (listener != nullptr) {
+            listener->onTurnEnd(*this);
+        }
+    }
+
+    int seatOf(const UnoPlayer& player) const {
+        return static_cast<int>(&player - &players[0]);
+    }
+
+    // 抽一张牌给该座位
+    UnoCard drawFor(int seat) {
+        UnoCard card = deck.drawCard();
+        players[seat].addCard(card);
+        if (brain != nullptr) {
+            brain->onCardDrawn(seat, card);
+        }
+        return card;
+    }
+
+    void notifyForcedDraw(int seat, const UnoCard& topCard) {
+        if (brain != nullptr) {
+            brain->onForcedDraw(seat, topCard);
+        }
+    }
+
+    void notifyPass(int seat) {
+        if (brain != nullptr) {
+            brain->onPass(seat);
+        }
+    }
+
+    // 电脑为野生牌选色
+    UnoCard::Color computerColor(UnoCard::Type playedType) {
+        if (brain != nullptr) {
+            return brain->chooseColor(*this, playedType);
+        }
+        return static_cast<UnoCard::Color>(rand() % 4);
+    }
+
+    void stopAdvisor() {
+        if (advisor != nullptr) {
+            advisor->stopAnalysis();
+        }
+    }
+
+    // 等待玩家按键；分析进行中时每隔一小段时间用新的胜率重绘画面，按键仍然立即返回
+    int waitForKey() {
+        if (advisor == nullptr) {
+            return waitKey(0);
+        }
+        int shownSamples = 0;
+        vector<double> winRates;
+        while (true) {
+            int key = waitKey(50);
+            if (key >= 0) {
+                return key;
+            }
+            int samples = advisor->getEstimates(winRates);
+            if (samples != shownSamples) {
+                shownSamples = samples;
+                imshow("UNO game", renderGameState());
+            }
+        }
+    }
 
 public:
-    UnoGame() : gameOver(false), clockwise(true) {
+    UnoGame() : gameOver(false), clockwise(true), cardsPlayed(0), listener(nullptr), advisor(nullptr), brain(nullptr) {
         // 初始化游戏
         initializeGame();
     }
@@ -353,6 +559,13 @@ public:
     void displayGameState() {
         system("cls"); // 清屏（Windows系统使用system("cls")）
 
+        // 显示窗口
+        imshow("UNO game", renderGameState());
+        waitKey(100);
+    }
+
+    // 绘制游戏画面
+    Mat renderGameState() const {
         // 创建游戏窗口
         Mat gameWindow = Mat(600, 1200, CV_8UC3, Scalar(0, 100, 0));
 
@@ -392,12 +605,42 @@ public:
             putText(gameWindow, indexText, Point(50 + i * 90, 370), FONT_HERSHEY_SIMPLEX, 0.5, Scalar(255, 255, 255), 1);
         }
 
+        // 显示出牌参考
+        drawAdvice(gameWindow);
+
         // 显示操作提示
         putText(gameWindow, "Press the number button to select the card you want to play, and press the D button to draw the card", Point(0, 550), FONT_HERSHEY_SIMPLEX, 0.6, Scalar(255, 255, 255), 1);
 
-        // 显示窗口
-        imshow("UNO game", gameWindow);
-        waitKey(100);
+        return gameWindow;
+    }
+
+    // 在每张可打的牌下方显示估计胜率，最高的用黄色
+    void drawAdvice(Mat& gameWindow) const {
+        if (advisor == nullptr) {
+            return;
+        }
+        vector<double> winRates;
+        int samples = advisor->getEstimates(winRates);
+        if (samples == 0) {
+            return;
+        }
+
+        double best = *max_element(winRates.begin(), winRates.end());
+        auto percent = [](double rate) {
+            return to_string(static_cast<int>(rate * 100 + 0.5)) + "%";
+        };
+        auto colorOf = [best](double rate) {
+            return rate == best ? Scalar(0, 255, 255) : Scalar(255, 255, 255);
+        };
+
+        size_t handSize = winRates.size() - 1;
+        for (size_t i = 0; i < handSize; i++) {
+            if (winRates[i] >= 0) {
+                putText(gameWindow, percent(winRates[i]), Point(60 + i * 90, 520), FONT_HERSHEY_SIMPLEX, 0.5, colorOf(winRates[i]), 1);
+            }
+        }
+        putText(gameWindow, "D: " + percent(winRates[handSize]), Point(700, 350), FONT_HERSHEY_SIMPLEX, 0.6, colorOf(winRates[handSize]), 1);
+        putText(gameWindow, "simulations: " + to_string(samples), Point(850, 350), FONT_HERSHEY_SIMPLEX, 0.5, Scalar(255, 255, 255), 1);
     }
 
     // 玩家回合
@@ -416,8 +659,8 @@ public:
             cout << "你没有可打的牌，必须抽一张牌。" << endl;
             waitKey(1000);
 
-            UnoCard drawnCard = deck.drawCard();
-            currentPlayer.addCard(drawnCard);
+            notifyForcedDraw(currentPlayerIndex, topCard);
+            UnoCard drawnCard = drawFor(currentPlayerIndex);
 
             cout << "你抽到了: " << drawnCard.toString() << endl;
 
@@ -434,6 +677,7 @@ public:
             }
             else {
                 cout << "这张牌不能打，轮到下一位玩家。" << endl;
+                notifyPass(currentPlayerIndex);
                 waitKey(1000);
             }
         }
@@ -441,8 +685,13 @@ public:
             // 有可打的牌，等待玩家选择
             bool cardPlayed = false;
 
+            // 后台开始估计每个选择的胜率
+            if (advisor != nullptr) {
+                advisor->startAnalysis(*this);
+            }
+
             while (!cardPlayed) {
-                int key = waitKey(0);
+                int key = waitForKey();
 
                 // 按数字键选择要出的牌
                 if (key >= '1' && key <= '9') {
@@ -451,6 +700,7 @@ public:
                     // 检查选择的牌是否有效
                     if (selectedIndex < currentPlayer.getHand().size()) {
                         if (currentPlayer.getHand()[selectedIndex].canBePlacedOn(topCard)) {
+                            stopAdvisor();
                             playCard(currentPlayer, selectedIndex);
                             cardPlayed = true;
                         }
@@ -461,8 +711,8 @@ public:
                 }
                 // 按D键抽牌
                 else if (key == 'd' || key == 'D') {
-                    UnoCard drawnCard = deck.drawCard();
-                    currentPlayer.addCard(drawnCard);
+                    stopAdvisor();
+                    UnoCard drawnCard = drawFor(currentPlayerIndex);
 
                     cout << "你抽到了: " << drawnCard.toString() << endl;
 
@@ -485,6 +735,7 @@ public:
                     }
                     else {
                         cout << "这张牌不能打，轮到下一位玩家。" << endl;
+                        notifyPass(currentPlayerIndex);
                         waitKey(1000);
                         cardPlayed = true;
                     }
@@ -510,8 +761,8 @@ public:
             cout << currentPlayer.getName() << "没有可打的牌，抽一张牌。" << endl;
             waitKey(1000);
 
-            UnoCard drawnCard = deck.drawCard();
-            currentPlayer.addCard(drawnCard);
+            notifyForcedDraw(currentPlayerIndex, topCard);
+            UnoCard drawnCard = drawFor(currentPlayerIndex);
 
             // 检查抽到的牌是否可以打
             if (drawnCard.canBePlacedOn(topCard)) {
@@ -524,6 +775,7 @@ public:
             }
             else {
                 cout << currentPlayer.getName() << "抽到的牌不能打，跳过回合。" << endl;
+                notifyPass(currentPlayerIndex);
                 waitKey(1000);
             }
         }
@@ -533,39 +785,19 @@ public:
             int bestCardIndex = -1;
             int highestValue = -1;
 
-            for (int index : playableIndices) {
-                const UnoCard& card = currentPlayer.getHand()[index];
-                int value = 0;
-
-                // 根据牌的类型和颜色分配权重
-                if (card.getType() == UnoCard::WILD_DRAW_FOUR) {
-                    value = 5;
-                }
-                else if (card.getType() == UnoCard::DRAW_TWO) {
-                    value = 4;
-                }
-                else if (card.getType() == UnoCard::SKIP) {
-                    value = 3;
-                }
-                else if (card.getType() == UnoCard::REVERSE) {
-                    value = 3;
-                }
-                else if (card.getType() == UnoCard::WILD_COLOR) {
-                    value = 2;
-                }
-                else {
-                    // 数字牌，值越高越好
-                    value = card.getNumber();
-                }
-
-                // 尝试匹配当前颜色
-                if (card.getColor() == topCard.getColor()) {
-                    value += 1;
-                }
-
-                if (value > highestValue) {
-                    highestValue = value;
-                    bestCardIndex = index;
+            if (brain != nullptr) {
+                bestCardIndex = brain->chooseCard(*this, playableIndices);
+            }
+            else {
+                for (int index : playableIndices) {
+                    const UnoCard& card = currentPlayer.getHand()[index];
+                    // 根据牌的类型和颜色分配权重
+                    int value = computerWeights.cardValue(card.getType(), card.getColor(), card.getNumber(), topCard.getColor());
+
+                    if (value > highestValue) {
+                        highestValue = value;
+                        bestCardIndex = index;
+                    }
                 }
             }
 
@@ -584,6 +816,10 @@ public:
 
         // 将牌放入弃牌堆
         discardPile.push(card);
+        cardsPlayed++;
+        if (brain != nullptr) {
+            brain->onCardPlayed(seatOf(player), card);
+        }
 
         // 检查玩家是否获胜
         if (player.hasWon()) {
@@ -623,7 +859,7 @@ public:
 
             for (int i = 0; i < 2; i++) {
                 if (!deck.isEmpty()) {
-                    nextPlayer.addCard(deck.drawCard());
+                    drawFor(nextPlayerIndex);
                 }
             }
 
@@ -655,8 +891,8 @@ public:
                 cout << "你选择了: " << getColorName(newColor) << endl;
             }
             else {
-                // 电脑随机选择一种颜色
-                UnoCard::Color newColor = static_cast<UnoCard::Color>(rand() % 4);
+                // 电脑选择一种颜色
+                UnoCard::Color newColor = computerColor(card.getType());
                 card.setColor(newColor);
 
                 // 更新弃牌堆中的牌
@@ -692,8 +928,8 @@ public:
                 cout << "你选择了: " << getColorName(newColor) << endl;
             }
             else {
-                // 电脑随机选择一种颜色
-                UnoCard::Color newColor = static_cast<UnoCard::Color>(rand() % 4);
+                // 电脑选择一种颜色
+                UnoCard::Color newColor = computerColor(card.getType());
                 card.setColor(newColor);
 
                 // 更新弃牌堆中的牌
@@ -710,7 +946,7 @@ public:
 
             for (int i = 0; i < 4; i++) {
                 if (!deck.isEmpty()) {
-                    drawFourPlayer.addCard(deck.drawCard());
+                    drawFor(drawFourPlayerIndex);
                 }
             }
 
@@ -756,6 +992,10 @@ public:
         imshow("UNO游戏", welcomeWindow);
         waitKey(0);
         destroyWindow("UNO游戏");
+        if (brain != nullptr) {
+            brain->beginGame(*this);
+        }
+        notifyListener();
 
         // 游戏主循环
         while (!gameOver) {
@@ -776,6 +1016,9 @@ public:
 
                 discardPile.push(topCard);
                 deck.shuffle();
+                if (brain != nullptr) {
+                    brain->onReshuffle();
+                }
             }
 
             // 当前玩家回合
@@ -790,6 +1033,7 @@ public:
             if (!gameOver) {
                 nextPlayer();
             }
+            notifyListener();
         }
 
         // 显示游戏结果
@@ -833,11 +1077,4200 @@ public:
     bool isGameOver() const {
         return gameOver;
     }
+
+    // 设置对局监听（不转移所有权）
+    void setListener(UnoGameListener* l) {
+        listener = l;
+    }
+
+    // 设置电脑玩家的决策（不转移所有权）
+    void setComputerBrain(UnoComputerBrain* b) {
+        brain = b;
+    }
+
+    // 设置出牌参考（不转移所有权）
+    void setAdvisor(UnoMoveAdvisor* a) {
+        advisor = a;
+    }
+
+    const vector<UnoPlayer>& getPlayers() const {
+        return players;
+    }
+
+    const UnoCard& getTopCard() const {
+        return discardPile.back();
+    }
+
+    const queue<UnoCard>& getDiscardPile() const {
+        return discardPile;
+    }
+
+    int getCurrentPlayer() const {
+        return currentPlayerIndex;
+    }
+
+    bool isClockwise() const {
+        return clockwise;
+    }
+
+    int getDeckSize() const {
+        return deck.size();
+    }
+
+    int getCardsPlayed() const {
+        return cardsPlayed;
+    }
 };
 
-int main() {
-    // 创建游戏对象
-    UnoGame game;
+// 命令行参数解析（形如 --name value 的选项）
+class CommandLine {
+private:
+    string program;
+    vector<string> args;
+
+public:
+    CommandLine(int argc, char* argv[]) : program(argc > 0 ? argv[0] : "uno_game") {
+        for (int i = 1; i < argc; i++) {
+            args.push_back(argv[i]);
+        }
+    }
+
+    // 获取程序自身的路径（用于启动子进程）
+    const string& getProgram() const {
+        return program;
+    }
+
+    // 检查是否带有某个选项
+    bool has(const string& name) const {
+        return find(args.begin(), args.end(), name) != args.end();
+    }
+
+    // 获取选项后面的值，没有则返回默认值
+    string getString(const string& name, const string& defaultValue) const {
+        for (size_t i = 0; i + 1 < args.size(); i++) {
+            if (args[i] == name) {
+                return args[i + 1];
+            }
+        }
+        return defaultValue;
+    }
+
+    long long getInt(const string& name, long long defaultValue) const {
+        string value = getString(name, "");
+        try {
+            return value.empty() ? defaultValue : stoll(value);
+        }
+        catch (const logic_error&) {
+            throw runtime_error(name + " 应为整数: " + value);
+        }
+    }
+
+    double getDouble(const string& name, double defaultValue) const {
+        string value = getString(name, "");
+        try {
+            return value.empty() ? defaultValue : stod(value);
+        }
+        catch (const logic_error&) {
+            throw runtime_error(name + " 应为数字: " + value);
+        }
+    }
+};
+
+// FNV-1a散列，用于校验和与配置指纹
+uint64_t fnv1a(const uint8_t* data, size_t size, uint64_t hash = 0xCBF29CE484222325ULL) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+uint64_t fnv1a(const string& text) {
+    return fnv1a(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+// 64位整数混合（splitmix64的收尾步骤）
+uint64_t mixHash(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// 按小端序写入二进制数据，与机器字节序无关
+class BinaryWriter {
+private:
+    vector<uint8_t> bytes;
+
+public:
+    void writeU8(uint8_t value) {
+        bytes.push_back(value);
+    }
+
+    void writeU32(uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            bytes.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void writeU64(uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            bytes.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void writeBytes(const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), p, p + size);
+    }
+
+    vector<uint8_t>& getBytes() {
+        return bytes;
+    }
+
+    const vector<uint8_t>& getBytes() const {
+        return bytes;
+    }
+
+    // 在末尾追加前面所有内容的校验和
+    void writeChecksum() {
+        writeU64(fnv1a(bytes.data(), bytes.size()));
+    }
+};
+
+// 按小端序读取二进制数据，越界时抛出异常
+class BinaryReader {
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+
+    void require(size_t count) {
+        if (offset + count > size) {
+            throw runtime_error("二进制数据不完整");
+        }
+    }
+
+public:
+    BinaryReader(const uint8_t* d, size_t s) : data(d), size(s), offset(0) {}
+
+    uint8_t readU8() {
+        require(1);
+        return data[offset++];
+    }
+
+    uint32_t readU32() {
+        require(4);
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) {
+            value |= static_cast<uint32_t>(data[offset++]) << (8 * i);
+        }
+        return value;
+    }
+
+    uint64_t readU64() {
+        require(8);
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++) {
+            value |= static_cast<uint64_t>(data[offset++]) << (8 * i);
+        }
+        return value;
+    }
+
+    void readBytes(void* out, size_t count) {
+        require(count);
+        memcpy(out, data + offset, count);
+        offset += count;
+    }
+
+    size_t getOffset() const {
+        return offset;
+    }
+
+    // 校验末尾的校验和（覆盖之前的所有字节）
+    void verifyChecksum() {
+        size_t covered = offset;
+        uint64_t expected = readU64();
+        if (fnv1a(data, covered) != expected) {
+            throw runtime_error("校验和不匹配");
+        }
+    }
+};
+
+// 读取整个文件
+vector<uint8_t> readFileBytes(const string& path) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        throw runtime_error("无法打开文件: " + path);
+    }
+    return vector<uint8_t>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+// 写入整个文件
+void writeFileBytes(const string& path, const vector<uint8_t>& bytes) {
+    ofstream file(path, ios::binary);
+    if (!file) {
+        throw runtime_error("无法写入文件: " + path);
+    }
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+// 创建目录（已存在则忽略）
+void makeDirectory(const string& path) {
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+// 列出目录下以prefix开头、以suffix结尾的文件
+vector<string> listFiles(const string& dir, const string& prefix, const string& suffix) {
+    vector<string> names;
+#ifdef _WIN32
+    _finddata_t entry;
+    intptr_t handle = _findfirst((dir + "\\" + prefix + "*" + suffix).c_str(), &entry);
+    if (handle != -1) {
+        do {
+            names.push_back(entry.name);
+        } while (_findnext(handle, &entry) == 0);
+        _findclose(handle);
+    }
+#else
+    DIR* handle = opendir(dir.c_str());
+    if (handle != nullptr) {
+        while (dirent* entry = readdir(handle)) {
+            string name = entry->d_name;
+            if (name.size() >= prefix.size() + suffix.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                names.push_back(name);
+            }
+        }
+        closedir(handle);
+    }
+#endif
+    sort(names.begin(), names.end());
+    for (auto& name : names) {
+        name = dir + "/" + name;
+    }
+    return names;
+}
+
+// 解析"起始:结束"格式的种子区间（左闭右开）
+void parseSeedRange(const string& text, uint64_t& begin, uint64_t& end) {
+    size_t colon = text.find(':');
+    if (colon == string::npos) {
+        throw runtime_error("种子区间格式应为 起始:结束");
+    }
+    begin = stoull(text.substr(0, colon));
+    end = stoull(text.substr(colon + 1));
+    if (end < begin) {
+        throw runtime_error("种子区间无效: " + text);
+    }
+}
+
+// 可复现的随机数生成器（splitmix64），同一种子在任何平台上产生相同序列
+class SimRng {
+private:
+    uint64_t state;
+
+public:
+    explicit SimRng(uint64_t seed = 0) : state(seed) {}
+
+    uint64_t getState() const {
+        return state;
+    }
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // 返回 [0, n) 之间的整数
+    int nextInt(int n) {
+        return static_cast<int>(next() % static_cast<uint64_t>(n));
+    }
+
+    // 返回 [0, 1) 之间的小数
+    double nextDouble() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+// 模拟用的轻量牌，不带牌面图像，规则与UnoCard一致
+class SimCard {
+private:
+    uint8_t color;
+    uint8_t type;
+    uint8_t number;
+
+public:
+    SimCard() : color(UnoCard::WILD), type(UnoCard::NUMBER), number(0) {}
+
+    SimCard(UnoCard::Color c, UnoCard::Type t, int num = 0)
+        : color(static_cast<uint8_t>(c)), type(static_cast<uint8_t>(t)), number(static_cast<uint8_t>(num)) {}
+
+    static SimCard fromUnoCard(const UnoCard& card) {
+        return SimCard(card.getColor(), card.getType(), card.getNumber());
+    }
+
+    UnoCard::Color getColor() const {
+        return static_cast<UnoCard::Color>(color);
+    }
+
+    UnoCard::Type getType() const {
+        return static_cast<UnoCard::Type>(type);
+    }
+
+    int getNumber() const {
+        return number;
+    }
+
+    bool isWild() const {
+        return type == UnoCard::WILD_COLOR || type == UnoCard::WILD_DRAW_FOUR;
+    }
+
+    // 设置牌的颜色（仅用于野生牌）
+    void setColor(UnoCard::Color c) {
+        if (isWild()) {
+            color = static_cast<uint8_t>(c);
+        }
+    }
+
+    // 牌面编码：高4位为颜色，低4位为0-9数字或10-14功能牌
+    uint8_t getCode() const {
+        int face = (type == UnoCard::NUMBER) ? number : 9 + type;
+        return static_cast<uint8_t>((color << 4) | face);
+    }
+
+    static SimCard fromCode(uint8_t code) {
+        int face = code & 0x0F;
+        UnoCard::Color c = static_cast<UnoCard::Color>(code >> 4);
+        if (face <= 9) {
+            return SimCard(c, UnoCard::NUMBER, face);
+        }
+        return SimCard(c, static_cast<UnoCard::Type>(face - 9));
+    }
+
+    // 获取牌的字符串表示（与UnoCard一致）
+    string toString() const {
+        string colors[] = { "红", "黄", "绿", "蓝", "野生" };
+        string types[] = { "数字", "跳过", "反转", " Draw Two", "野生颜色", " Draw Four" };
+
+        if (type == UnoCard::NUMBER) {
+            return colors[color] + " " + to_string(number);
+        }
+        else if (isWild()) {
+            return types[type] + (color != UnoCard::WILD ? "(" + colors[color] + ")" : "");
+        }
+        return colors[color] + " " + types[type];
+    }
+
+    bool operator==(const SimCard& other) const {
+        return color == other.color && type == other.type && number == other.number;
+    }
+
+    // 检查这张牌是否可以放在另一张牌上面
+    bool canBePlacedOn(const SimCard& other) const {
+        if (isWild()) {
+            return true;
+        }
+        if (color == other.color) {
+            return true;
+        }
+        if (type == other.type && type != UnoCard::NUMBER) {
+            return true;
+        }
+        return type == UnoCard::NUMBER && other.type == UnoCard::NUMBER && number == other.number;
+    }
+};
+
+class SimGame;
+
+// 模拟对局的事件监听（观战、记录、推测对手手牌等）
+class SimObserver {
+public:
+    virtual ~SimObserver() {}
+
+    // 玩家打出一张牌（野生牌已带有所选颜色）
+    virtual void onCardPlayed(const SimGame&, int, const SimCard&) {}
+
+    // 玩家得到一张牌（包括罚抽）
+    virtual void onCardDrawn(const SimGame&, int, const SimCard&) {}
+
+    // 玩家没有可打的牌而抽牌，topCard为当时的顶牌
+    virtual void onForcedDraw(const SimGame&, int, const SimCard&) {}
+
+    // 玩家抽到的牌不能打，跳过回合
+    virtual void onPass(const SimGame&, int) {}
+
+    // 弃牌堆（除顶牌外）洗回牌堆
+    virtual void onReshuffle(const SimGame&) {}
+};
+
+// 模拟对局中的出牌策略
+class UnoPolicy {
+public:
+    virtual ~UnoPolicy() {}
+
+    // 对局开始时调用，策略可以在这里挂上自己的监听
+    virtual void beginGame(SimGame&, int) {}
+
+    // 从可打的牌中选择一张，返回手牌索引；返回-1表示主动抽牌
+    virtual int chooseCard(const SimGame& game, const vector<int>& playableIndices) = 0;
+
+    // 抽到可打的牌时是否立即打出
+    virtual bool playDrawnCard(const SimGame&) {
+        return true;
+    }
+
+    // 为野生牌选择颜色，默认与电脑一样随机选择
+    virtual UnoCard::Color chooseColor(SimGame& game);
+};
+
+// 无界面的UNO规则引擎，规则与UnoGame相同，用于批量模拟
+// 牌堆洗牌和电脑选色都只使用种子决定的随机数，同一种子的对局可以完全复现
+class SimGame {
+public:
+    static const int MAX_TURNS = 3000; // 超过此回合数按平局处理
+
+private:
+    SimRng rng;
+    vector<SimCard> deck;
+    vector<vector<SimCard>> hands;
+    vector<SimCard> discardPile;
+    vector<int> scratch;
+    vector<SimObserver*> observers;
+    int currentPlayerIndex;
+    bool clockwise;
+    bool gameOver;
+    int winner;
+    int turnCount;
+    int cardsPlayed;
+    bool pendingDraw; // 当前玩家抽到了可打的牌，等待出牌或保留
+
+    // 初始化一副标准UNO牌
+    void initializeDeck() {
+        deck = standardDeck();
+    }
+
+    bool hasPlayableCard(int seat) const {
+        for (const SimCard& card : hands[seat]) {
+            if (card.canBePlacedOn(discardPile.back())) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Fisher-Yates洗牌
+    void shuffleDeck() {
+        for (int i = static_cast<int>(deck.size()) - 1; i > 0; i--) {
+            swap(deck[i], deck[rng.nextInt(i + 1)]);
+        }
+    }
+
+    SimCard drawFromDeck() {
+        SimCard card = deck.back();
+        deck.pop_back();
+        return card;
+    }
+
+    // 牌堆为空时保留弃牌堆顶部的牌，其余的牌重新洗入牌堆
+    void refillDeck() {
+        if (!deck.empty() || discardPile.size() <= 1) {
+            return;
+        }
+        SimCard topCard = discardPile.back();
+        discardPile.pop_back();
+        for (SimCard card : discardPile) {
+            if (card.isWild()) {
+                card.setColor(UnoCard::WILD);
+            }
+            deck.push_back(card);
+        }
+        discardPile.clear();
+        discardPile.push_back(topCard);
+        shuffleDeck();
+        for (SimObserver* observer : observers) {
+            observer->onReshuffle(*this);
+        }
+    }
+
+    // 罚抽，牌堆空了就少抽（与UnoGame一致）
+    void drawPenalty(int seat, int count) {
+        for (int i = 0; i < count && !deck.empty(); i++) {
+            hands[seat].push_back(drawFromDeck());
+            for (SimObserver* observer : observers) {
+                observer->onCardDrawn(*this, seat, hands[seat].back());
+            }
+        }
+    }
+
+    void nextPlayer() {
+        currentPlayerIndex = getNextPlayerIndex();
+    }
+
+    // 结束当前回合，轮到下一位玩家
+    void endTurn() {
+        pendingDraw = false;
+        turnCount++;
+        if (turnCount >= MAX_TURNS) {
+            gameOver = true;
+            winner = -1;
+            return;
+        }
+        nextPlayer();
+        refillDeck();
+    }
+
+public:
+    // 一副标准UNO牌（108张）
+    static vector<SimCard> standardDeck() {
+        vector<SimCard> cards;
+        for (int color = 0; color < 4; color++) {
+            UnoCard::Color c = static_cast<UnoCard::Color>(color);
+            cards.push_back(SimCard(c, UnoCard::NUMBER, 0));
+            for (int num = 1; num <= 9; num++) {
+                cards.push_back(SimCard(c, UnoCard::NUMBER, num));
+                cards.push_back(SimCard(c, UnoCard::NUMBER, num));
+            }
+            for (int i = 0; i < 2; i++) {
+                cards.push_back(SimCard(c, UnoCard::SKIP));
+                cards.push_back(SimCard(c, UnoCard::REVERSE));
+                cards.push_back(SimCard(c, UnoCard::DRAW_TWO));
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            cards.push_back(SimCard(UnoCard::WILD, UnoCard::WILD_COLOR));
+            cards.push_back(SimCard(UnoCard::WILD, UnoCard::WILD_DRAW_FOUR));
+        }
+        return cards;
+    }
+
+    SimGame(uint64_t seed, int numPlayers = 4, int handSize = 7)
+        : rng(seed), hands(numPlayers), currentPlayerIndex(0), clockwise(true),
+          gameOver(false), winner(-1), turnCount(0), cardsPlayed(0), pendingDraw(false) {
+        initializeDeck();
+        deal(handSize);
+    }
+
+    // 使用自定义的牌（例如缩小的牌堆）开局，牌中至少要有一张数字牌
+    SimGame(uint64_t seed, int numPlayers, int handSize, const vector<SimCard>& cards)
+        : rng(seed), deck(cards), hands(numPlayers), currentPlayerIndex(0), clockwise(true),
+          gameOver(false), winner(-1), turnCount(0), cardsPlayed(0), pendingDraw(false) {
+        deal(handSize);
+    }
+
+    // 从给定局面开始（例如对真实对局的确定化模拟），弃牌堆最后一张为顶牌
+    SimGame(uint64_t seed, const vector<vector<SimCard>>& startHands, const vector<SimCard>& startDeck,
+            const vector<SimCard>& startDiscard, int currentPlayer, bool cw)
+        : rng(seed), deck(startDeck), hands(startHands), discardPile(startDiscard), currentPlayerIndex(currentPlayer),
+          clockwise(cw), gameOver(false), winner(-1), turnCount(0), cardsPlayed(0), pendingDraw(false) {}
+
+private:
+    // 洗牌、发牌并翻开起始牌
+    void deal(int handSize) {
+        if (deck.size() <= hands.size() * static_cast<size_t>(handSize)) {
+            throw runtime_error("牌堆太小，不够发牌");
+        }
+        shuffleDeck();
+
+        // 给每个玩家发牌
+        for (int i = 0; i < handSize; i++) {
+            for (auto& hand : hands) {
+                hand.push_back(drawFromDeck());
+            }
+        }
+
+        // 起始牌必须是数字牌，发完牌后牌堆里没有数字牌就无法开局
+        bool hasNumber = false;
+        for (const SimCard& card : deck) {
+            hasNumber = hasNumber || card.getType() == UnoCard::NUMBER;
+        }
+        if (!hasNumber) {
+            throw runtime_error("发牌后牌堆中没有数字牌可作起始牌");
+        }
+        SimCard startCard = drawFromDeck();
+        while (startCard.getType() != UnoCard::NUMBER) {
+            deck.push_back(startCard);
+            shuffleDeck();
+            startCard = drawFromDeck();
+        }
+        discardPile.push_back(startCard);
+    }
+
+public:
+
+    // 获取玩家手中可打出的牌的索引
+    void getPlayableCards(int seat, vector<int>& playableIndices) const {
+        playableIndices.clear();
+        const SimCard& topCard = discardPile.back();
+        const vector<SimCard>& hand = hands[seat];
+        for (size_t i = 0; i < hand.size(); i++) {
+            if (hand[i].canBePlacedOn(topCard)) {
+                playableIndices.push_back(static_cast<int>(i));
+            }
+        }
+    }
+
+    // 当前玩家打出一张牌，chosenColor仅对野生牌有效
+    void playCard(int cardIndex, UnoCard::Color chosenColor) {
+        vector<SimCard>& hand = hands[currentPlayerIndex];
+        SimCard card = hand[cardIndex];
+        hand.erase(hand.begin() + cardIndex);
+        card.setColor(chosenColor);
+        discardPile.push_back(card);
+        cardsPlayed++;
+        pendingDraw = false;
+        for (SimObserver* observer : observers) {
+            observer->onCardPlayed(*this, currentPlayerIndex, card);
+        }
+
+        // 检查玩家是否获胜
+        if (hand.empty()) {
+            turnCount++;
+            gameOver = true;
+            winner = currentPlayerIndex;
+            return;
+        }
+
+        // 处理功能牌的效果
+        switch (card.getType()) {
+        case UnoCard::SKIP:
+            nextPlayer();
+            break;
+        case UnoCard::REVERSE:
+            clockwise = !clockwise;
+            break;
+        case UnoCard::DRAW_TWO:
+            drawPenalty(getNextPlayerIndex(), 2);
+            nextPlayer();
+            break;
+        case UnoCard::WILD_DRAW_FOUR:
+            drawPenalty(getNextPlayerIndex(), 4);
+            nextPlayer();
+            break;
+        default:
+            break;
+        }
+        endTurn();
+    }
+
+    // 当前玩家抽一张牌；抽到可打的牌返回true，等待playCard或keepDrawnCard，否则直接结束回合
+    bool drawCard() {
+        int seat = currentPlayerIndex;
+        if (!observers.empty() && !hasPlayableCard(seat)) {
+            for (SimObserver* observer : observers) {
+                observer->onForcedDraw(*this, seat, discardPile.back());
+            }
+        }
+
+        if (!deck.empty()) {
+            hands[seat].push_back(drawFromDeck());
+            for (SimObserver* observer : observers) {
+                observer->onCardDrawn(*this, seat, hands[seat].back());
+            }
+            if (hands[seat].back().canBePlacedOn(discardPile.back())) {
+                pendingDraw = true;
+                return true;
+            }
+        }
+
+        // 抽到的牌不能打（或牌堆和弃牌堆都已耗尽），跳过回合
+        for (SimObserver* observer : observers) {
+            observer->onPass(*this, seat);
+        }
+        endTurn();
+        return false;
+    }
+
+    // 保留抽到的可打的牌，结束回合
+    void keepDrawnCard() {
+        endTurn();
+    }
+
+    // 用给定策略走完当前玩家的一个回合
+    void playTurn(UnoPolicy& policy) {
+        getPlayableCards(currentPlayerIndex, scratch);
+        int choice = scratch.empty() ? -1 : policy.chooseCard(*this, scratch);
+
+        if (choice < 0) {
+            if (!drawCard()) {
+                return;
+            }
+            if (!policy.playDrawnCard(*this)) {
+                keepDrawnCard();
+                return;
+            }
+            choice = static_cast<int>(hands[currentPlayerIndex].size()) - 1;
+        }
+
+        UnoCard::Color color = UnoCard::WILD;
+        if (hands[currentPlayerIndex][choice].isWild()) {
+            color = policy.chooseColor(*this);
+        }
+        playCard(choice, color);
+    }
+
+    // 每个座位使用对应的策略把对局下完，返回获胜者座位（平局返回-1）
+    int playOut(const vector<UnoPolicy*>& seatPolicies) {
+        for (int seat = 0; seat < getNumPlayers(); seat++) {
+            seatPolicies[seat]->beginGame(*this, seat);
+        }
+        while (!gameOver) {
+            playTurn(*seatPolicies[currentPlayerIndex]);
+        }
+        return winner;
+    }
+
+    // 添加事件监听；复制对局时监听也会被复制，需要时先清空
+    void addObserver(SimObserver* observer) {
+        observers.push_back(observer);
+    }
+
+    void clearObservers() {
+        observers.clear();
+    }
+
+    // 获取下一位玩家的索引
+    int getNextPlayerIndex() const {
+        return getSeatAfter(currentPlayerIndex, 1, clockwise);
+    }
+
+    // 从seat开始沿给定方向数steps个座位
+    int getSeatAfter(int seat, int steps, bool cw) const {
+        int numPlayers = static_cast<int>(hands.size());
+        int offset = cw ? steps : numPlayers - steps % numPlayers;
+        return (seat + offset) % numPlayers;
+    }
+
+    // 打出这种牌之后，第一个需要接牌的座位
+    int getRespondingSeat(UnoCard::Type type) const {
+        return respondingSeat(currentPlayerIndex, getNumPlayers(), clockwise, type);
+    }
+
+    // 同上，用于界面对局等没有SimGame的场合
+    static int respondingSeat(int seat, int numPlayers, bool cw, UnoCard::Type type) {
+        int steps = 1;
+        switch (type) {
+        case UnoCard::SKIP:
+        case UnoCard::DRAW_TWO:
+        case UnoCard::WILD_DRAW_FOUR:
+            steps = 2;
+            break;
+        case UnoCard::REVERSE:
+            cw = !cw;
+            break;
+        default:
+            break;
+        }
+        int offset = cw ? steps : numPlayers - steps % numPlayers;
+        return (seat + offset) % numPlayers;
+    }
+
+    const vector<SimCard>& getHand(int seat) const {
+        return hands[seat];
+    }
+
+    const SimCard& getTopCard() const {
+        return discardPile.back();
+    }
+
+    const vector<SimCard>& getDeck() const {
+        return deck;
+    }
+
+    const vector<SimCard>& getDiscardPile() const {
+        return discardPile;
+    }
+
+    int getNumPlayers() const {
+        return static_cast<int>(hands.size());
+    }
+
+    int getCurrentPlayer() const {
+        return currentPlayerIndex;
+    }
+
+    bool isClockwise() const {
+        return clockwise;
+    }
+
+    bool isGameOver() const {
+        return gameOver;
+    }
+
+    bool hasPendingDraw() const {
+        return pendingDraw;
+    }
+
+    int getWinner() const {
+        return winner;
+    }
+
+    int getTurnCount() const {
+        return turnCount;
+    }
+
+    int getCardsPlayed() const {
+        return cardsPlayed;
+    }
+
+    int getDeckSize() const {
+        return static_cast<int>(deck.size());
+    }
+
+    SimRng& getRng() {
+        return rng;
+    }
+
+    // 局面散列（不同的basis得到互相独立的散列），用于置换表
+    // 弃牌堆中被盖住的野生牌洗回牌堆时会恢复成无色，所以不计它们选过的颜色
+    uint64_t hashState(uint64_t basis) const {
+        uint64_t hash = basis;
+        auto mix = [&hash](uint64_t value) {
+            hash = (hash ^ value) * 0x100000001B3ULL;
+        };
+        mix(rng.getState());
+        mix(static_cast<uint64_t>(turnCount));
+        mix(static_cast<uint64_t>(currentPlayerIndex) | (clockwise ? 0x100 : 0) | (pendingDraw ? 0x200 : 0) | (gameOver ? 0x400 : 0));
+        for (const auto& hand : hands) {
+            for (const SimCard& card : hand) {
+                mix(card.getCode());
+            }
+            mix(0x1FF);
+        }
+        for (const SimCard& card : deck) {
+            mix(card.getCode());
+        }
+        mix(0x1FF);
+        for (size_t i = 0; i < discardPile.size(); i++) {
+            SimCard card = discardPile[i];
+            if (i + 1 < discardPile.size() && card.isWild()) {
+                card.setColor(UnoCard::WILD);
+            }
+            mix(card.getCode());
+        }
+        return hash;
+    }
+};
+
+UnoCard::Color UnoPolicy::chooseColor(SimGame& game) {
+    return static_cast<UnoCard::Color>(game.getRng().nextInt(4));
+}
+
+// 与computerTurn相同的权重策略：选价值最高的牌，没有可打的牌才抽牌
+class HeuristicPolicy : public UnoPolicy {
+protected:
+    HeuristicWeights weights;
+
+public:
+    explicit HeuristicPolicy(const HeuristicWeights& w = HeuristicWeights()) : weights(w) {}
+
+    int chooseCard(const SimGame& game, const vector<int>& playableIndices) override {
+        const vector<SimCard>& hand = game.getHand(game.getCurrentPlayer());
+        UnoCard::Color topColor = game.getTopCard().getColor();
+        int bestCardIndex = -1;
+        int highestValue = -1;
+
+        for (int index : playableIndices) {
+            const SimCard& card = hand[index];
+            int value = weights.cardValue(card.getType(), card.getColor(), card.getNumber(), topColor);
+            if (value > highestValue) {
+                highestValue = value;
+                bestCardIndex = index;
+            }
+        }
+        return bestCardIndex;
+    }
+};
+
+// 从某个座位的视角推测各对手手牌的增量模型
+// 维护未见牌的种类计数，以及每个对手手牌中“可能是某颜色”的牌数：
+// 对手在顶牌为X时被迫抽牌（或抽到的牌打不出），说明当时手中没有X色牌和野生牌，
+// 之后新抽的牌才可能是X色。每个事件的更新都是常数时间
+class BeliefTracker : public SimObserver {
+public:
+    static const int KINDS = 80;    // 牌种编号 = 颜色*16 + 牌面，见SimCard::getCode
+    static const int COLORS = 5;    // 四种颜色加野生牌
+    static const int MAX_SEATS = 10;
+
+    // 野生牌不论选了什么颜色都算作同一种
+    static int kindOf(const SimCard& card) {
+        if (card.isWild()) {
+            SimCard wild = card;
+            wild.setColor(UnoCard::WILD);
+            return wild.getCode();
+        }
+        return card.getCode();
+    }
+
+private:
+    int observerSeat;
+    int numPlayers;
+    int unseen[KINDS];              // 观察者看不到的牌（牌堆和对手手中）
+    int unseenByColor[COLORS];
+    int totalUnseen;
+    int discardCounts[KINDS];       // 弃牌堆中的牌（洗牌时回到未见牌中）
+    int topKind;
+    int handSize[MAX_SEATS];
+    int possible[MAX_SEATS][COLORS]; // 手牌中可能是该颜色的牌数
+    int forcedSeat;                 // 本回合被迫抽牌的座位，-1表示没有
+    int forcedColor;                // 被迫抽牌时的顶牌颜色
+
+    void addUnseen(int kind, int count) {
+        unseen[kind] += count;
+        unseenByColor[kind >> 4] += count;
+        totalUnseen += count;
+    }
+
+    // 记录某座位当时手中没有该颜色和野生牌
+    void markVoid(int seat, int color) {
+        if (color < UnoCard::WILD) {
+            possible[seat][color] = 0;
+        }
+        possible[seat][UnoCard::WILD] = 0;
+    }
+
+    void clampToHand(int seat) {
+        for (int c = 0; c < COLORS; c++) {
+            possible[seat][c] = min(possible[seat][c], handSize[seat]);
+        }
+    }
+
+public:
+    // 从当前局面开始跟踪：此前的历史不计入，对手手牌视为完全未知
+    BeliefTracker(const SimGame& game, int seat)
+        : observerSeat(seat), numPlayers(game.getNumPlayers()), totalUnseen(0), forcedSeat(-1), forcedColor(-1) {
+        memset(unseen, 0, sizeof(unseen));
+        memset(unseenByColor, 0, sizeof(unseenByColor));
+        memset(discardCounts, 0, sizeof(discardCounts));
+        for (const SimCard& card : game.getDeck()) {
+            addUnseen(kindOf(card), 1);
+        }
+        for (int s = 0; s < numPlayers; s++) {
+            const vector<SimCard>& hand = game.getHand(s);
+            handSize[s] = static_cast<int>(hand.size());
+            for (int c = 0; c < COLORS; c++) {
+                possible[s][c] = handSize[s];
+            }
+            if (s != observerSeat) {
+                for (const SimCard& card : hand) {
+                    addUnseen(kindOf(card), 1);
+                }
+            }
+        }
+        for (const SimCard& card : game.getDiscardPile()) {
+            discardCounts[kindOf(card)]++;
+        }
+        topKind = kindOf(game.getTopCard());
+    }
+
+    // 只根据公开信息开始跟踪（例如界面对局）：看不到的牌 = 整副牌 - 自己的手牌 - 弃牌堆
+    BeliefTracker(int seat, const vector<SimCard>& ownHand, const vector<int>& handSizes, const vector<SimCard>& discardPile)
+        : observerSeat(seat), numPlayers(static_cast<int>(handSizes.size())), totalUnseen(0), forcedSeat(-1), forcedColor(-1) {
+        memset(unseen, 0, sizeof(unseen));
+        memset(unseenByColor, 0, sizeof(unseenByColor));
+        memset(discardCounts, 0, sizeof(discardCounts));
+        for (const SimCard& card : SimGame::standardDeck()) {
+            addUnseen(kindOf(card), 1);
+        }
+        for (const SimCard& card : ownHand) {
+            addUnseen(kindOf(card), -1);
+        }
+        for (const SimCard& card : discardPile) {
+            addUnseen(kindOf(card), -1);
+            discardCounts[kindOf(card)]++;
+        }
+        for (int s = 0; s < numPlayers; s++) {
+            handSize[s] = handSizes[s];
+            for (int c = 0; c < COLORS; c++) {
+                possible[s][c] = handSize[s];
+            }
+        }
+        topKind = kindOf(discardPile.back());
+    }
+
+    void onCardPlayed(const SimGame&, int seat, const SimCard& card) override {
+        cardPlayed(seat, card);
+    }
+
+    void onCardDrawn(const SimGame&, int seat, const SimCard& card) override {
+        cardDrawn(seat, card);
+    }
+
+    void onForcedDraw(const SimGame&, int seat, const SimCard& topCard) override {
+        forcedDraw(seat, topCard);
+    }
+
+    void onPass(const SimGame&, int seat) override {
+        passed(seat);
+    }
+
+    void onReshuffle(const SimGame&) override {
+        reshuffled();
+    }
+
+    // 以下事件处理不依赖SimGame，界面对局也直接调用
+    void cardPlayed(int seat, const SimCard& card) {
+        int kind = kindOf(card);
+        if (seat != observerSeat) {
+            addUnseen(kind, -1);
+            int color = kind >> 4;
+            possible[seat][color] = max(0, possible[seat][color] - 1);
+        }
+        handSize[seat]--;
+        clampToHand(seat);
+        forcedSeat = -1;
+        discardCounts[kind]++;
+        topKind = kind;
+    }
+
+    void cardDrawn(int seat, const SimCard& card) {
+        // 被迫抽牌的座位保留了抽到的牌时没有事件，下一个座位行动时回合已经结束
+        if (seat != forcedSeat) {
+            forcedSeat = -1;
+        }
+        handSize[seat]++;
+        if (seat == observerSeat) {
+            addUnseen(kindOf(card), -1);
+            return;
+        }
+        for (int c = 0; c < COLORS; c++) {
+            possible[seat][c]++;
+        }
+    }
+
+    void forcedDraw(int seat, const SimCard& topCard) {
+        forcedSeat = seat;
+        forcedColor = topCard.getColor();
+        markVoid(seat, forcedColor);
+    }
+
+    void passed(int seat) {
+        // 紧接着同一回合的被迫抽牌：抽到的牌也打不出，同样不是该颜色
+        if (seat == forcedSeat) {
+            markVoid(seat, forcedColor);
+        }
+        forcedSeat = -1;
+    }
+
+    void reshuffled() {
+        for (int kind = 0; kind < KINDS; kind++) {
+            if (discardCounts[kind] > 0) {
+                addUnseen(kind, discardCounts[kind]);
+                discardCounts[kind] = 0;
+            }
+        }
+        addUnseen(topKind, -1);
+        discardCounts[topKind] = 1;
+    }
+
+    int getHandSize(int seat) const {
+        return handSize[seat];
+    }
+
+    int getUnseenCount(const SimCard& card) const {
+        return unseen[kindOf(card)];
+    }
+
+    // 一张未见的牌是该颜色（WILD表示野生牌）的概率
+    double unseenColorShare(int color) const {
+        return totalUnseen > 0 ? static_cast<double>(unseenByColor[color]) / totalUnseen : 0.0;
+    }
+
+    // 该座位手牌中可能是该颜色的比例（每色似然）
+    double colorLikelihood(int seat, int color) const {
+        return handSize[seat] > 0 ? static_cast<double>(possible[seat][color]) / handSize[seat] : 0.0;
+    }
+
+    // 该座位至少有一张该颜色牌的概率
+    double probHasColor(int seat, int color) const {
+        return 1.0 - pow(1.0 - unseenColorShare(color), possible[seat][color]);
+    }
+
+    // 该座位能接上颜色为color的顶牌的概率（有该颜色或有野生牌）
+    double probCanAnswerColor(int seat, int color) const {
+        double noColor = pow(1.0 - unseenColorShare(color), possible[seat][color]);
+        double noWild = pow(1.0 - unseenColorShare(UnoCard::WILD), possible[seat][UnoCard::WILD]);
+        return 1.0 - noColor * noWild;
+    }
+
+    // 该座位手牌中各颜色的期望张数，out[0..4]之和等于手牌数
+    void expectedHandComposition(int seat, double out[COLORS]) const {
+        double total = 0.0;
+        for (int c = 0; c < COLORS; c++) {
+            out[c] = possible[seat][c] * unseenColorShare(c);
+            total += out[c];
+        }
+        for (int c = 0; c < COLORS; c++) {
+            out[c] = total > 0.0 ? out[c] * handSize[seat] / total : 0.0;
+        }
+    }
+};
+
+// 在权重策略的基础上考虑对手手牌：优先打出下一个接牌的人大概率接不上的颜色，
+// 野生牌也选择对方最可能接不上的颜色
+class BeliefPolicy : public HeuristicPolicy {
+private:
+    double beliefWeight;
+    unique_ptr<BeliefTracker> trackers[BeliefTracker::MAX_SEATS];
+    UnoCard::Type lastChosenType;
+
+public:
+    // 对手最可能接不上的颜色
+    static UnoCard::Color weakestColor(const BeliefTracker& tracker, int responder, double& answerProb) {
+        UnoCard::Color best = UnoCard::RED;
+        answerProb = 2.0;
+        for (int c = 0; c < 4; c++) {
+            double p = tracker.probCanAnswerColor(responder, c);
+            if (p < answerProb) {
+                answerProb = p;
+                best = static_cast<UnoCard::Color>(c);
+            }
+        }
+        return best;
+    }
+
+    // 权重价值加上接牌人接不上的概率
+    static double cardValue(const HeuristicWeights& weights, double beliefWeight, const BeliefTracker& tracker,
+                            const SimCard& card, UnoCard::Color topColor, int responder) {
+        double answerProb;
+        if (card.isWild()) {
+            weakestColor(tracker, responder, answerProb);
+        }
+        else {
+            answerProb = tracker.probCanAnswerColor(responder, card.getColor());
+        }
+        return weights.cardValue(card.getType(), card.getColor(), card.getNumber(), topColor) +
+               beliefWeight * (1.0 - answerProb);
+    }
+
+    BeliefPolicy(const HeuristicWeights& w, double bw) : HeuristicPolicy(w), beliefWeight(bw), lastChosenType(UnoCard::WILD_COLOR) {}
+
+    void beginGame(SimGame& game, int seat) override {
+        trackers[seat].reset(new BeliefTracker(game, seat));
+        game.addObserver(trackers[seat].get());
+    }
+
+    int chooseCard(const SimGame& game, const vector<int>& playableIndices) override {
+        int seat = game.getCurrentPlayer();
+        const BeliefTracker& tracker = *trackers[seat];
+        const vector<SimCard>& hand = game.getHand(seat);
+        UnoCard::Color topColor = game.getTopCard().getColor();
+        int bestCardIndex = -1;
+        double highestValue = -1e9;
+
+        for (int index : playableIndices) {
+            const SimCard& card = hand[index];
+            double value = cardValue(weights, beliefWeight, tracker, card, topColor, game.getRespondingSeat(card.getType()));
+            if (value > highestValue) {
+                highestValue = value;
+                bestCardIndex = index;
+            }
+        }
+        if (bestCardIndex >= 0) {
+            lastChosenType = hand[bestCardIndex].getType();
+        }
+        return bestCardIndex;
+    }
+
+    bool playDrawnCard(const SimGame& game) override {
+        lastChosenType = game.getHand(game.getCurrentPlayer()).back().getType();
+        return true;
+    }
+
+    UnoCard::Color chooseColor(SimGame& game) override {
+        int seat = game.getCurrentPlayer();
+        double answerProb;
+        return weakestColor(*trackers[seat], game.getRespondingSeat(lastChosenType), answerProb);
+    }
+};
+
+// 界面对局中的电脑玩家：每个座位一个BeliefTracker，出牌和选色与BeliefPolicy相同
+class BeliefComputerBrain : public UnoComputerBrain {
+public:
+    static constexpr double DEFAULT_BELIEF_WEIGHT = 1.0; // A/B测试中对默认权重最好的取值
+
+private:
+    HeuristicWeights weights;
+    double beliefWeight;
+    vector<unique_ptr<BeliefTracker>> trackers;
+
+public:
+    explicit BeliefComputerBrain(const HeuristicWeights& w = HeuristicWeights(), double bw = DEFAULT_BELIEF_WEIGHT)
+        : weights(w), beliefWeight(bw) {}
+
+    void beginGame(const UnoGame& game) override {
+        const vector<UnoPlayer>& players = game.getPlayers();
+        vector<int> handSizes;
+        for (const UnoPlayer& player : players) {
+            handSizes.push_back(static_cast<int>(player.getHand().size()));
+        }
+        vector<SimCard> discard;
+        queue<UnoCard> pile = game.getDiscardPile();
+        while (!pile.empty()) {
+            discard.push_back(SimCard::fromUnoCard(pile.front()));
+            pile.pop();
+        }
+
+        trackers.clear();
+        for (size_t seat = 0; seat < players.size(); seat++) {
+            vector<SimCard> hand;
+            for (const UnoCard& card : players[seat].getHand()) {
+                hand.push_back(SimCard::fromUnoCard(card));
+            }
+            trackers.push_back(unique_ptr<BeliefTracker>(new BeliefTracker(static_cast<int>(seat), hand, handSizes, discard)));
+        }
+    }
+
+    void onCardPlayed(int seat, const UnoCard& card) override {
+        for (auto& tracker : trackers) {
+            tracker->cardPlayed(seat, SimCard::fromUnoCard(card));
+        }
+    }
+
+    // 抽到的牌只有本座位的跟踪器会用到，其他座位只记手牌数
+    void onCardDrawn(int seat, const UnoCard& card) override {
+        for (auto& tracker : trackers) {
+            tracker->cardDrawn(seat, SimCard::fromUnoCard(card));
+        }
+    }
+
+    void onForcedDraw(int seat, const UnoCard& topCard) override {
+        for (auto& tracker : trackers) {
+            tracker->forcedDraw(seat, SimCard::fromUnoCard(topCard));
+        }
+    }
+
+    void onPass(int seat) override {
+        for (auto& tracker : trackers) {
+            tracker->passed(seat);
+        }
+    }
+
+    void onReshuffle() override {
+        for (auto& tracker : trackers) {
+            tracker->reshuffled();
+        }
+    }
+
+    int chooseCard(const UnoGame& game, const vector<int>& playableIndices) override {
+        int seat = game.getCurrentPlayer();
+        int numPlayers = static_cast<int>(game.getPlayers().size());
+        const vector<UnoCard>& hand = game.getPlayers()[seat].getHand();
+        UnoCard::Color topColor = game.getTopCard().getColor();
+        int bestCardIndex = -1;
+        double highestValue = -1e9;
+
+        for (int index : playableIndices) {
+            SimCard card = SimCard::fromUnoCard(hand[index]);
+            int responder = SimGame::respondingSeat(seat, numPlayers, game.isClockwise(), card.getType());
+            double value = BeliefPolicy::cardValue(weights, beliefWeight, *trackers[seat], card, topColor, responder);
+            if (value > highestValue) {
+                highestValue = value;
+                bestCardIndex = index;
+            }
+        }
+        return bestCardIndex;
+    }
+
+    UnoCard::Color chooseColor(const UnoGame& game, UnoCard::Type playedType) override {
+        int seat = game.getCurrentPlayer();
+        int numPlayers = static_cast<int>(game.getPlayers().size());
+        int responder = SimGame::respondingSeat(seat, numPlayers, game.isClockwise(), playedType);
+        double answerProb;
+        return BeliefPolicy::weakestColor(*trackers[seat], responder, answerProb);
+    }
+};
+
+// 学习策略使用的着法特征，每个候选着法（打出某张牌或抽牌）一行
+class MoveFeatures {
+public:
+    static const int COUNT = 16;
+    enum Index {
+        BIAS,            // 常数1
+        WILD_DRAW_FOUR,  // 牌型（独热）
+        DRAW_TWO,
+        SKIP,
+        REVERSE,
+        WILD_COLOR,
+        NUMBER,
+        NUMBER_VALUE,    // 数字牌的牌面/9
+        COLOR_MATCH,     // 与顶牌同色
+        FACE_MATCH,      // 靠数字或牌型接上（颜色不同）
+        SAME_COLOR_LEFT, // 打出后手中同色牌的比例
+        HAND_SIZE,       // 打出后的手牌数/10
+        ATTACK_NEXT,     // 跳过/+2/+4时为 1/下家手牌数
+        DRAW,            // 抽牌
+        WILD_HAND_SIZE,  // 野生牌时为手牌数/10（手牌多时保留野生牌）
+        PADDING
+    };
+
+    // 每次决策只需统计一次的信息
+    struct Context {
+        int colorCounts[5];
+        int handSize;
+        int nextHandSize;
+        UnoCard::Color topColor;
+    };
+
+    static void makeContext(const SimGame& game, Context& ctx) {
+        const vector<SimCard>& hand = game.getHand(game.getCurrentPlayer());
+        memset(ctx.colorCounts, 0, sizeof(ctx.colorCounts));
+        for (const SimCard& card : hand) {
+            ctx.colorCounts[card.isWild() ? UnoCard::WILD : card.getColor()]++;
+        }
+        ctx.handSize = static_cast<int>(hand.size());
+        ctx.nextHandSize = static_cast<int>(game.getHand(game.getNextPlayerIndex()).size());
+        ctx.topColor = game.getTopCard().getColor();
+    }
+
+    // 提取一个候选着法的特征，cardIndex为-1表示抽牌
+    static void extract(const SimGame& game, const Context& ctx, int cardIndex, float out[COUNT]) {
+        memset(out, 0, sizeof(float) * COUNT);
+        out[BIAS] = 1.0f;
+        if (cardIndex < 0) {
+            out[DRAW] = 1.0f;
+            out[HAND_SIZE] = (ctx.handSize + 1) / 10.0f;
+            return;
+        }
+
+        const SimCard& card = game.getHand(game.getCurrentPlayer())[cardIndex];
+        switch (card.getType()) {
+        case UnoCard::WILD_DRAW_FOUR: out[WILD_DRAW_FOUR] = 1.0f; break;
+        case UnoCard::DRAW_TWO: out[DRAW_TWO] = 1.0f; break;
+        case UnoCard::SKIP: out[SKIP] = 1.0f; break;
+        case UnoCard::REVERSE: out[REVERSE] = 1.0f; break;
+        case UnoCard::WILD_COLOR: out[WILD_COLOR] = 1.0f; break;
+        default:
+            out[NUMBER] = 1.0f;
+            out[NUMBER_VALUE] = card.getNumber() / 9.0f;
+            break;
+        }
+
+        int left = ctx.handSize - 1;
+        if (card.isWild()) {
+            out[WILD_HAND_SIZE] = ctx.handSize / 10.0f;
+        }
+        else {
+            out[COLOR_MATCH] = card.getColor() == ctx.topColor ? 1.0f : 0.0f;
+            out[FACE_MATCH] = 1.0f - out[COLOR_MATCH];
+            out[SAME_COLOR_LEFT] = left > 0 ? (ctx.colorCounts[card.getColor()] - 1) / static_cast<float>(left) : 0.0f;
+        }
+        out[HAND_SIZE] = left / 10.0f;
+
+        UnoCard::Type type = card.getType();
+        if (type == UnoCard::SKIP || type == UnoCard::DRAW_TWO || type == UnoCard::WILD_DRAW_FOUR) {
+            out[ATTACK_NEXT] = 1.0f / max(ctx.nextHandSize, 1);
+        }
+    }
+};
+
+// 线性着法打分模型，保存为带版本号的二进制文件
+class PolicyModel {
+public:
+    static const uint32_t MAGIC = 0x574F4E55; // "UNOW"
+    static const uint32_t VERSION = 1;
+
+    float weights[MoveFeatures::COUNT];
+
+    PolicyModel() {
+        memset(weights, 0, sizeof(weights));
+    }
+
+    // 与权重表等价的初始模型（同分时都选靠前的牌）
+    static PolicyModel fromHeuristic(const HeuristicWeights& w) {
+        PolicyModel model;
+        model.weights[MoveFeatures::WILD_DRAW_FOUR] = static_cast<float>(w.wildDrawFour);
+        model.weights[MoveFeatures::DRAW_TWO] = static_cast<float>(w.drawTwo);
+        model.weights[MoveFeatures::SKIP] = static_cast<float>(w.skip);
+        model.weights[MoveFeatures::REVERSE] = static_cast<float>(w.reverse);
+        model.weights[MoveFeatures::WILD_COLOR] = static_cast<float>(w.wildColor);
+        model.weights[MoveFeatures::NUMBER_VALUE] = 9.0f;
+        model.weights[MoveFeatures::COLOR_MATCH] = static_cast<float>(w.colorMatch);
+        model.weights[MoveFeatures::DRAW] = -20.0f; // 有牌可打时不主动抽牌
+        return model;
+    }
+
+    void save(const string& path) const {
+        BinaryWriter writer;
+        writer.writeU32(MAGIC);
+        writer.writeU32(VERSION);
+        writer.writeU32(MoveFeatures::COUNT);
+        for (float w : weights) {
+            uint32_t bits;
+            memcpy(&bits, &w, sizeof(bits));
+            writer.writeU32(bits);
+        }
+        writer.writeChecksum();
+        writeFileBytes(path, writer.getBytes());
+    }
+
+    static PolicyModel load(const string& path) {
+        vector<uint8_t> bytes = readFileBytes(path);
+        BinaryReader reader(bytes.data(), bytes.size());
+        if (reader.readU32() != MAGIC || reader.readU32() != VERSION || reader.readU32() != MoveFeatures::COUNT) {
+            throw runtime_error("不是策略模型文件或版本不符: " + path);
+        }
+        PolicyModel model;
+        for (float& w : model.weights) {
+            uint32_t bits = reader.readU32();
+            memcpy(&w, &bits, sizeof(w));
+        }
+        reader.verifyChecksum();
+        return model;
+    }
+
+    string toString() const {
+        string text;
+        for (int i = 0; i < MoveFeatures::COUNT; i++) {
+            text += (i > 0 ? "," : "") + to_string(weights[i]);
+        }
+        return text;
+    }
+};
+
+// 对按列存放的候选着法批量打分：out[i] = Σ weights[f] * columns[f * stride + i]
+void scoreMovesScalar(const float* columns, int stride, int count, const float* weights, float* out) {
+    for (int i = 0; i < count; i++) {
+        out[i] = 0.0f;
+    }
+    for (int f = 0; f < MoveFeatures::COUNT; f++) {
+        const float* column = columns + f * stride;
+        for (int i = 0; i < count; i++) {
+            out[i] += weights[f] * column[i];
+        }
+    }
+}
+
+#ifdef UNO_AVX2_KERNEL
+// 同上，一次算8个着法。只有这个函数使用AVX2指令，其余代码按默认指令集编译
+// stride是8的倍数，最后不满8个的部分也会计算（结果忽略）
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+void scoreMovesAvx2(const float* columns, int stride, int count, const float* weights, float* out) {
+    for (int i = 0; i < count; i += 8) {
+        __m256 acc = _mm256_setzero_ps();
+        for (int f = 0; f < MoveFeatures::COUNT; f++) {
+            __m256 x = _mm256_loadu_ps(columns + f * stride + i);
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_broadcast_ss(weights + f), x));
+        }
+        _mm256_storeu_ps(out + i, acc);
+    }
+}
+
+// CPU支持AVX2，并且操作系统会保存YMM寄存器
+bool cpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+void scoreMoves(const float* columns, int stride, int count, const float* weights, float* out) {
+#ifdef UNO_AVX2_KERNEL
+    static const bool useAvx2 = cpuHasAvx2();
+    if (useAvx2) {
+        scoreMovesAvx2(columns, stride, count, weights, out);
+        return;
+    }
+#endif
+    scoreMovesScalar(columns, stride, count, weights, out);
+}
+
+// 一批候选着法的特征（按特征分列存放，便于SIMD打分），可以来自多局对局
+class FeatureBatch {
+private:
+    vector<float> columns;
+    vector<float> scores;
+    int stride;
+    int count;
+
+public:
+    FeatureBatch() : stride(0), count(0) {}
+
+    // 清空并预留capacity行
+    void reset(int capacity) {
+        stride = (capacity + 7) & ~7;
+        if (columns.size() < static_cast<size_t>(MoveFeatures::COUNT) * stride) {
+            columns.assign(static_cast<size_t>(MoveFeatures::COUNT) * stride, 0.0f);
+        }
+        if (scores.size() < static_cast<size_t>(stride)) {
+            scores.assign(stride, 0.0f);
+        }
+        count = 0;
+    }
+
+    // 添加一行，返回行号
+    int add(const float features[MoveFeatures::COUNT]) {
+        for (int f = 0; f < MoveFeatures::COUNT; f++) {
+            columns[f * stride + count] = features[f];
+        }
+        return count++;
+    }
+
+    void getRow(int row, float out[MoveFeatures::COUNT]) const {
+        for (int f = 0; f < MoveFeatures::COUNT; f++) {
+            out[f] = columns[f * stride + row];
+        }
+    }
+
+    // 给所有行打分
+    const float* score(const PolicyModel& model) {
+        scoreMoves(columns.data(), stride, count, model.weights, scores.data());
+        return scores.data();
+    }
+
+    int size() const {
+        return count;
+    }
+};
+
+// 使用学习到的模型选牌（贪心），抽牌也作为一个候选着法
+class LearnedPolicy : public UnoPolicy {
+private:
+    const PolicyModel& model;
+    FeatureBatch batch;
+    MoveFeatures::Context ctx;
+    vector<int> candidates;
+
+public:
+    explicit LearnedPolicy(const PolicyModel& m) : model(m) {}
+
+    int chooseCard(const SimGame& game, const vector<int>& playableIndices) override {
+        candidates = playableIndices;
+        candidates.push_back(-1);
+        MoveFeatures::makeContext(game, ctx);
+        batch.reset(static_cast<int>(candidates.size()));
+        float features[MoveFeatures::COUNT];
+        for (int index : candidates) {
+            MoveFeatures::extract(game, ctx, index, features);
+            batch.add(features);
+        }
+
+        const float* scores = batch.score(model);
+        int best = 0;
+        for (int i = 1; i < batch.size(); i++) {
+            if (scores[i] > scores[best]) {
+                best = i;
+            }
+        }
+        return candidates[best];
+    }
+};
+
+// 两个出牌策略的序贯A/B测试
+// 每个种子下两局：座位按ABAB和BABA轮换，两局牌堆相同（公共随机数），
+// 以一对对局中B的得分（0, 0.5, ..., 2）为五项分布样本，每批并行模拟后更新SPRT，
+// 结论显著或被排除时立即停止
+class PolicyAbTest {
+public:
+    struct Config {
+        HeuristicWeights weightsA;  // 基准策略
+        HeuristicWeights weightsB;  // 候选策略
+        double beliefWeightB = 0.0; // 大于0时候选策略额外使用BeliefPolicy推测对手手牌
+        string modelPathB;          // 非空时候选策略使用该学习模型
+        double elo0 = 0.0;          // H0: B比A强不到elo0
+        double elo1 = 10.0;         // H1: B比A强至少elo1
+        double alpha = 0.05;
+        double beta = 0.05;
+        int batchPairs = 2000;
+        long long maxPairs = 1000000;
+        int threads = 0;            // 0表示使用全部核心
+        uint64_t baseSeed = 1;
+    };
+
+private:
+    // 一批对局的统计，pentanomial[k]为B在一对对局中得k/2分的次数
+    struct Counts {
+        long long pentanomial[5] = {};
+        long long winsA = 0;
+        long long winsB = 0;
+        long long draws = 0;
+
+        void add(const Counts& other) {
+            for (int k = 0; k < 5; k++) {
+                pentanomial[k] += other.pentanomial[k];
+            }
+            winsA += other.winsA;
+            winsB += other.winsB;
+            draws += other.draws;
+        }
+    };
+
+    Config config;
+    Counts total;
+    PolicyModel modelB;
+
+    // 下一局，返回B的得分（以半分计：0, 1, 2）
+    static int playGame(uint64_t seed, UnoPolicy& a, UnoPolicy& b, bool bFirst, Counts& counts) {
+        vector<UnoPolicy*> seats;
+        for (int seat = 0; seat < 4; seat++) {
+            bool isB = (seat % 2 == 0) == bFirst;
+            seats.push_back(isB ? &b : &a);
+        }
+        SimGame game(seed);
+        int winner = game.playOut(seats);
+        if (winner < 0) {
+            counts.draws++;
+            return 1;
+        }
+        if (seats[winner] == &b) {
+            counts.winsB++;
+            return 2;
+        }
+        counts.winsA++;
+        return 0;
+    }
+
+    // 并行下一批成对对局，按线程切分种子区间后汇总
+    void playBatch(uint64_t firstSeed, int pairCount) {
+        int threadCount = config.threads > 0 ? config.threads : max(1u, thread::hardware_concurrency());
+        threadCount = min(threadCount, pairCount);
+        vector<Counts> partial(threadCount);
+        vector<thread> workers;
+
+        for (int t = 0; t < threadCount; t++) {
+            int begin = static_cast<int>(static_cast<long long>(pairCount) * t / threadCount);
+            int end = static_cast<int>(static_cast<long long>(pairCount) * (t + 1) / threadCount);
+            workers.push_back(thread([this, &partial, t, begin, end, firstSeed]() {
+                HeuristicPolicy a(config.weightsA);
+                unique_ptr<UnoPolicy> b;
+                if (!config.modelPathB.empty()) {
+                    b.reset(new LearnedPolicy(modelB));
+                }
+                else if (config.beliefWeightB > 0.0) {
+                    b.reset(new BeliefPolicy(config.weightsB, config.beliefWeightB));
+                }
+                else {
+                    b.reset(new HeuristicPolicy(config.weightsB));
+                }
+                for (int i = begin; i < end; i++) {
+                    uint64_t seed = firstSeed + i;
+                    int score = playGame(seed, a, *b, false, partial[t]) + playGame(seed, a, *b, true, partial[t]);
+                    partial[t].pentanomial[score]++;
+                }
+            }));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (const auto& counts : partial) {
+            total.add(counts);
+        }
+    }
+
+    static double eloToScore(double elo) {
+        return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+    }
+
+    static double scoreToElo(double score) {
+        score = min(max(score, 1e-6), 1.0 - 1e-6);
+        return -400.0 * log10(1.0 / score - 1.0);
+    }
+
+    long long pairCount() const {
+        long long n = 0;
+        for (int k = 0; k < 5; k++) {
+            n += total.pentanomial[k];
+        }
+        return n;
+    }
+
+    // 每对对局B的平均得分率及其方差
+    void scoreStats(double& mean, double& variance) const {
+        long long n = pairCount();
+        mean = 0.0;
+        variance = 0.0;
+        if (n == 0) {
+            return;
+        }
+        for (int k = 0; k < 5; k++) {
+            mean += total.pentanomial[k] * (k / 4.0);
+        }
+        mean /= n;
+        for (int k = 0; k < 5; k++) {
+            double d = k / 4.0 - mean;
+            variance += total.pentanomial[k] * d * d;
+        }
+        variance /= n;
+    }
+
+    // 广义SPRT的对数似然比（正态近似）
+    double logLikelihoodRatio() const {
+        double mean, variance;
+        scoreStats(mean, variance);
+        if (pairCount() == 0) {
+            return 0.0;
+        }
+        // 所有样本相同（例如两个策略完全一致）时方差为0，给一个下限避免除零
+        variance = max(variance, 1e-6);
+        double s0 = eloToScore(config.elo0);
+        double s1 = eloToScore(config.elo1);
+        return pairCount() * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * variance);
+    }
+
+public:
+    explicit PolicyAbTest(const Config& c) : config(c) {
+        if (!config.modelPathB.empty()) {
+            modelB = PolicyModel::load(config.modelPathB);
+        }
+    }
+
+    // 运行测试并打印结果，返回值：1接受H1，0接受H0，-1达到上限仍无结论
+    int run() {
+        double lower = log(config.beta / (1.0 - config.alpha));
+        double upper = log((1.0 - config.beta) / config.alpha);
+        int result = -1;
+
+        cout << "A: " << config.weightsA.toString() << "  B: " << config.weightsB.toString();
+        if (!config.modelPathB.empty()) {
+            cout << " -> model " << config.modelPathB;
+        }
+        else if (config.beliefWeightB > 0.0) {
+            cout << " + belief " << config.beliefWeightB;
+        }
+        cout << endl;
+        cout << "SPRT elo0=" << config.elo0 << " elo1=" << config.elo1
+             << " LLR区间[" << lower << ", " << upper << "]" << endl;
+
+        int batch = 0;
+        while (pairCount() < config.maxPairs) {
+            int count = static_cast<int>(min<long long>(config.batchPairs, config.maxPairs - pairCount()));
+            playBatch(config.baseSeed + pairCount(), count);
+
+            double llr = logLikelihoodRatio();
+            cout << "批次 " << ++batch << ": " << pairCount() << " 对, LLR = " << llr << endl;
+            if (llr >= upper) {
+                result = 1;
+                break;
+            }
+            if (llr <= lower) {
+                result = 0;
+                break;
+            }
+        }
+
+        printReport(result);
+        return result;
+    }
+
+    void printReport(int result) const {
+        double mean, variance;
+        scoreStats(mean, variance);
+        long long n = pairCount();
+        double margin = n > 0 ? 1.96 * sqrt(variance / n) : 0.0;
+        long long games = n * 2;
+
+        cout << "结论: " << (result == 1 ? "接受H1（B更强）" : result == 0 ? "接受H0（B没有显著提升）" : "未定") << endl;
+        cout << "对局数: " << games << "（上限 " << config.maxPairs * 2 << "）" << endl;
+        cout << "五项分布: ";
+        for (int k = 0; k < 5; k++) {
+            cout << total.pentanomial[k] << (k < 4 ? " " : "\n");
+        }
+        cout << "B胜: " << total.winsB << "  A胜: " << total.winsA << "  平局: " << total.draws << endl;
+        cout << "Elo差: " << scoreToElo(mean) << " [" << scoreToElo(mean - margin) << ", "
+             << scoreToElo(mean + margin) << "] (95%)" << endl;
+        cout << "胜率差(B-A): " << (2.0 * mean - 1.0) * 100.0 << "% +/- " << 2.0 * margin * 100.0 << "%" << endl;
+    }
+};
+
+// 命令行：--ab [--a 5,4,3,3,2,1] [--b ...] [--b-belief 0] [--b-model policy.bin] [--elo0 0] [--elo1 10] [--alpha 0.05] [--beta 0.05]
+//         [--batch 2000] [--max-pairs 1000000] [--threads 0] [--seed 1]
+int runAbTest(const CommandLine& args) {
+    PolicyAbTest::Config config;
+    config.weightsA = HeuristicWeights::parse(args.getString("--a", config.weightsA.toString()));
+    config.weightsB = HeuristicWeights::parse(args.getString("--b", config.weightsB.toString()));
+    config.beliefWeightB = args.getDouble("--b-belief", config.beliefWeightB);
+    config.modelPathB = args.getString("--b-model", config.modelPathB);
+    config.elo0 = args.getDouble("--elo0", config.elo0);
+    config.elo1 = args.getDouble("--elo1", config.elo1);
+    config.alpha = args.getDouble("--alpha", config.alpha);
+    config.beta = args.getDouble("--beta", config.beta);
+    config.batchPairs = static_cast<int>(args.getInt("--batch", config.batchPairs));
+    config.maxPairs = args.getInt("--max-pairs", config.maxPairs);
+    config.threads = static_cast<int>(args.getInt("--threads", config.threads));
+    config.baseSeed = static_cast<uint64_t>(args.getInt("--seed", static_cast<long long>(config.baseSeed)));
+
+    // 这些取值会让LLR的边界变成无穷或NaN，或者让每批没有对局，检验永远不会停止
+    if (!(config.alpha > 0.0 && config.alpha < 1.0) || !(config.beta > 0.0 && config.beta < 1.0)) {
+        throw runtime_error("--alpha 和 --beta 应在 (0, 1) 之间");
+    }
+    if (!(config.elo1 > config.elo0)) {
+        throw runtime_error("--elo1 应大于 --elo0");
+    }
+    if (config.batchPairs < 1 || config.maxPairs < 1) {
+        throw runtime_error("--batch 和 --max-pairs 应至少为1");
+    }
+
+    PolicyAbTest test(config);
+    test.run();
+    return 0;
+}
+
+// 一段种子区间的锦标赛结果汇总，可与相邻区间合并
+// 所有字段都是可交换的累加量，所以按任意分片合并后与单进程运行的结果逐字节相同
+class TournamentSummary {
+public:
+    static const uint32_t MAGIC = 0x534F4E55; // "UNOS"
+    static const uint32_t VERSION = 1;
+    static const int SEATS = 4;
+    static const int TURN_BINS = 64;       // 对局回合数直方图，每格10回合，最后一格含溢出
+    static const int TURN_BIN_WIDTH = 10;
+    static const int CARDS_BINS = 32;      // 输家剩余手牌数直方图，最后一格含溢出
+
+    uint64_t seedBegin = 0;
+    uint64_t seedEnd = 0;
+    uint64_t configHash = 0;  // 各座位策略的指纹，不同配置的分片不能合并
+    uint64_t games = 0;
+    uint64_t wins[SEATS] = {};
+    uint64_t draws = 0;
+    uint64_t turnHistogram[TURN_BINS] = {};
+    uint64_t cardsLeftHistogram[CARDS_BINS] = {};
+    uint64_t resultHash = 0;  // 每局(种子, 胜者, 回合数)散列之和
+
+    // 记录一局结果
+    void addGame(uint64_t seed, const SimGame& game) {
+        int winner = game.getWinner();
+        int turns = game.getTurnCount();
+        games++;
+        if (winner < 0) {
+            draws++;
+        }
+        else {
+            wins[winner]++;
+        }
+        turnHistogram[min(turns / TURN_BIN_WIDTH, TURN_BINS - 1)]++;
+        for (int seat = 0; seat < SEATS; seat++) {
+            if (seat != winner) {
+                cardsLeftHistogram[min(static_cast<int>(game.getHand(seat).size()), CARDS_BINS - 1)]++;
+            }
+        }
+        resultHash += mixHash(seed ^ mixHash((static_cast<uint64_t>(winner + 1) << 32) | static_cast<uint32_t>(turns)));
+    }
+
+    // 合并相邻区间的结果
+    void merge(const TournamentSummary& other) {
+        seedBegin = min(seedBegin, other.seedBegin);
+        seedEnd = max(seedEnd, other.seedEnd);
+        games += other.games;
+        for (int i = 0; i < SEATS; i++) {
+            wins[i] += other.wins[i];
+        }
+        draws += other.draws;
+        for (int i = 0; i < TURN_BINS; i++) {
+            turnHistogram[i] += other.turnHistogram[i];
+        }
+        for (int i = 0; i < CARDS_BINS; i++) {
+            cardsLeftHistogram[i] += other.cardsLeftHistogram[i];
+        }
+        resultHash += other.resultHash;
+    }
+
+    vector<uint8_t> serialize() const {
+        BinaryWriter writer;
+        writer.writeU32(MAGIC);
+        writer.writeU32(VERSION);
+        writer.writeU64(seedBegin);
+        writer.writeU64(seedEnd);
+        writer.writeU64(configHash);
+        writer.writeU64(games);
+        for (uint64_t w : wins) {
+            writer.writeU64(w);
+        }
+        writer.writeU64(draws);
+        for (uint64_t h : turnHistogram) {
+            writer.writeU64(h);
+        }
+        for (uint64_t h : cardsLeftHistogram) {
+            writer.writeU64(h);
+        }
+        writer.writeU64(resultHash);
+        writer.writeChecksum();
+        return writer.getBytes();
+    }
+
+    static TournamentSummary deserialize(const vector<uint8_t>& bytes) {
+        BinaryReader reader(bytes.data(), bytes.size());
+        if (reader.readU32() != MAGIC || reader.readU32() != VERSION) {
+            throw runtime_error("不是锦标赛结果文件或版本不符");
+        }
+        TournamentSummary summary;
+        summary.seedBegin = reader.readU64();
+        summary.seedEnd = reader.readU64();
+        summary.configHash = reader.readU64();
+        summary.games = reader.readU64();
+        for (uint64_t& w : summary.wins) {
+            w = reader.readU64();
+        }
+        summary.draws = reader.readU64();
+        for (uint64_t& h : summary.turnHistogram) {
+            h = reader.readU64();
+        }
+        for (uint64_t& h : summary.cardsLeftHistogram) {
+            h = reader.readU64();
+        }
+        summary.resultHash = reader.readU64();
+        reader.verifyChecksum();
+        if (summary.games != summary.seedEnd - summary.seedBegin) {
+            throw runtime_error("对局数与种子区间不符");
+        }
+        return summary;
+    }
+
+    // 显示汇总结果
+    void print() const {
+        cout << "种子区间 [" << seedBegin << ", " << seedEnd << "), 共 " << games << " 局" << endl;
+        for (int seat = 0; seat < SEATS; seat++) {
+            double rate = games > 0 ? 100.0 * wins[seat] / games : 0.0;
+            cout << "座位" << seat << " 胜: " << wins[seat] << " (" << rate << "%)" << endl;
+        }
+        cout << "平局: " << draws << endl;
+
+        uint64_t totalTurns = 0;
+        for (int i = 0; i < TURN_BINS; i++) {
+            totalTurns += turnHistogram[i] * (i * TURN_BIN_WIDTH + TURN_BIN_WIDTH / 2);
+        }
+        if (games > 0) {
+            cout << "平均回合数(按直方图估计): " << static_cast<double>(totalTurns) / games << endl;
+        }
+        cout << "结果散列: " << hex << resultHash << dec << endl;
+    }
+};
+
+// 运行一个分片并写出结果文件
+// 命令行：--shard --seeds 0:100000 --out shard.bin [--seats 5,4,3,3,2,1/.../...]
+int runShard(const CommandLine& args) {
+    uint64_t seedBegin, seedEnd;
+    parseSeedRange(args.getString("--seeds", "0:10000"), seedBegin, seedEnd);
+    string seatsText = args.getString("--seats", "");
+    string outPath = args.getString("--out", "shard.bin");
+
+    // 各座位策略，用'/'分隔，缺省使用默认权重
+    vector<HeuristicPolicy> policies;
+    stringstream ss(seatsText);
+    string item;
+    string normalized;
+    for (int seat = 0; seat < TournamentSummary::SEATS; seat++) {
+        HeuristicWeights weights;
+        if (getline(ss, item, '/') && !item.empty()) {
+            weights = HeuristicWeights::parse(item);
+        }
+        policies.push_back(HeuristicPolicy(weights));
+        normalized += weights.toString() + "/";
+    }
+    vector<UnoPolicy*> seats;
+    for (auto& policy : policies) {
+        seats.push_back(&policy);
+    }
+
+    TournamentSummary summary;
+    summary.seedBegin = seedBegin;
+    summary.seedEnd = seedEnd;
+    summary.configHash = fnv1a(normalized);
+    for (uint64_t seed = seedBegin; seed < seedEnd; seed++) {
+        SimGame game(seed);
+        game.playOut(seats);
+        summary.addGame(seed, game);
+    }
+
+    writeFileBytes(outPath, summary.serialize());
+    return 0;
+}
+
+// 合并目录中的所有分片，检查缺失和重复的种子区间；区间不连续时返回false
+bool mergeShardDirectory(const string& dir, TournamentSummary& merged) {
+    vector<TournamentSummary> shards;
+    for (const string& path : listFiles(dir, "shard_", ".bin")) {
+        try {
+            shards.push_back(TournamentSummary::deserialize(readFileBytes(path)));
+        }
+        catch (const exception& e) {
+            cout << "分片损坏 " << path << ": " << e.what() << endl;
+            return false;
+        }
+    }
+    if (shards.empty()) {
+        cout << "目录中没有分片: " << dir << endl;
+        return false;
+    }
+
+    sort(shards.begin(), shards.end(), [](const TournamentSummary& a, const TournamentSummary& b) {
+        return a.seedBegin != b.seedBegin ? a.seedBegin < b.seedBegin : a.seedEnd < b.seedEnd;
+    });
+
+    bool ok = true;
+    merged = shards[0];
+    for (size_t i = 1; i < shards.size(); i++) {
+        const TournamentSummary& shard = shards[i];
+        if (shard.configHash != merged.configHash) {
+            cout << "分片 [" << shard.seedBegin << ", " << shard.seedEnd << ") 的策略配置不同" << endl;
+            ok = false;
+        }
+        else if (shard.seedBegin < merged.seedEnd) {
+            cout << "种子区间重复: [" << shard.seedBegin << ", " << min(shard.seedEnd, merged.seedEnd) << ")" << endl;
+            ok = false;
+        }
+        else {
+            if (shard.seedBegin > merged.seedEnd) {
+                cout << "种子区间缺失: [" << merged.seedEnd << ", " << shard.seedBegin << ")" << endl;
+                ok = false;
+            }
+            merged.merge(shard);
+        }
+    }
+    return ok;
+}
+
+// 合并结果必须恰好覆盖请求的种子区间（分片缺在两端时区间检查发现不了）
+bool checkShardCoverage(const TournamentSummary& merged, uint64_t seedBegin, uint64_t seedEnd) {
+    if (merged.seedBegin == seedBegin && merged.seedEnd == seedEnd) {
+        return true;
+    }
+    cout << "分片覆盖 [" << merged.seedBegin << ", " << merged.seedEnd << ")，请求的是 ["
+         << seedBegin << ", " << seedEnd << ")" << endl;
+    return false;
+}
+
+// 命令行：--merge --dir shards [--seeds 0:1000000] [--out merged.bin]
+int runMerge(const CommandLine& args) {
+    string dir = args.getString("--dir", "shards");
+    TournamentSummary merged;
+    if (!mergeShardDirectory(dir, merged)) {
+        return 1;
+    }
+    if (args.has("--seeds")) {
+        uint64_t seedBegin, seedEnd;
+        parseSeedRange(args.getString("--seeds", ""), seedBegin, seedEnd);
+        if (!checkShardCoverage(merged, seedBegin, seedEnd)) {
+            return 1;
+        }
+    }
+    writeFileBytes(args.getString("--out", dir + "/merged.bin"), merged.serialize());
+    merged.print();
+    return 0;
+}
+
+// 把种子区间切成分片，每个分片由一个独立的子进程运行，完成后合并
+// 命令行：--tournament --seeds 0:1000000 [--shards 8] [--dir shards] [--seats ...]
+int runTournament(const CommandLine& args) {
+    uint64_t seedBegin, seedEnd;
+    parseSeedRange(args.getString("--seeds", "0:100000"), seedBegin, seedEnd);
+    long long shardArg = args.getInt("--shards", max(1u, thread::hardware_concurrency()));
+    if (shardArg < 1) {
+        throw runtime_error("--shards 应至少为1");
+    }
+    uint64_t shardCount = static_cast<uint64_t>(shardArg);
+    string dir = args.getString("--dir", "shards");
+    string seatsText = args.getString("--seats", "");
+    makeDirectory(dir);
+
+    // 删除上一次运行留下的分片，以免混入本次结果
+    for (const string& path : listFiles(dir, "shard_", ".bin")) {
+        if (remove(path.c_str()) != 0) {
+            cout << "无法删除旧分片: " << path << endl;
+            return 1;
+        }
+    }
+
+    vector<string> commands;
+    uint64_t range = seedEnd - seedBegin;
+    shardCount = max<uint64_t>(1, min(shardCount, range)); // 分片不多于种子数
+    for (uint64_t i = 0; i < shardCount; i++) {
+        uint64_t begin = seedBegin + range * i / shardCount;
+        uint64_t end = seedBegin + range * (i + 1) / shardCount;
+        if (begin == end) {
+            continue;
+        }
+        string seeds = to_string(begin) + ":" + to_string(end);
+        string command = "\"" + args.getProgram() + "\" --shard --seeds " + seeds +
+                         " --out \"" + dir + "/shard_" + to_string(begin) + "_" + to_string(end) + ".bin\"";
+        if (!seatsText.empty()) {
+            command += " --seats \"" + seatsText + "\"";
+        }
+#ifdef _WIN32
+        command = "\"" + command + "\""; // cmd会去掉最外层的一对引号
+#endif
+        commands.push_back(command);
+    }
+
+    // 每个分片一个线程，线程只负责等待子进程结束
+    vector<int> exitCodes(commands.size());
+    vector<thread> workers;
+    for (size_t i = 0; i < commands.size(); i++) {
+        workers.push_back(thread([&commands, &exitCodes, i]() {
+            exitCodes[i] = system(commands[i].c_str());
+        }));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    bool failed = false;
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (exitCodes[i] != 0) {
+            cout << "分片进程失败: " << commands[i] << endl;
+            failed = true;
+        }
+    }
+    if (failed) {
+        return 1;
+    }
+
+    TournamentSummary merged;
+    if (!mergeShardDirectory(dir, merged) || !checkShardCoverage(merged, seedBegin, seedEnd)) {
+        return 1;
+    }
+    writeFileBytes(dir + "/merged.bin", merged.serialize());
+    merged.print();
+    return 0;
+}
+
+// 自我对弈训练线性出牌模型
+// 每一代并行模拟大量对局（每个线程同时推进一批对局，所有对局的候选着法合成一批打分），
+// 按softmax探索采样，记录(特征, 着法, 胜负)样本，然后用策略梯度更新权重
+class SelfPlayTrainer {
+public:
+    struct Config {
+        int generations = 30;
+        int gamesPerGeneration = 20000;
+        int lockstepGames = 256;   // 每个线程同时推进的对局数
+        int threads = 0;           // 0表示使用全部核心
+        double temperature = 1.0;  // 探索温度
+        double learningRate = 50.0;
+        int evalPairs = 2000;      // 每代结束后与权重表对战的对局对数
+        uint64_t seed = 1;
+        string initPath;           // 为空时从权重表等价的模型开始
+        string outPath = "policy.bin";
+    };
+
+private:
+    // 一个线程产生的样本，特征按行存放
+    struct SampleBuffer {
+        vector<float> rows;
+        vector<uint32_t> firstRow;
+        vector<uint8_t> rowCount;
+        vector<uint8_t> chosen;
+        vector<float> outcome;
+
+        void clear() {
+            rows.clear();
+            firstRow.clear();
+            rowCount.clear();
+            chosen.clear();
+            outcome.clear();
+        }
+    };
+
+    Config config;
+    PolicyModel model;
+    int threadCount;
+
+    // 在多个线程上并行处理 [0, count)，fn(线程号, 起点, 终点)
+    template <typename Fn>
+    void parallelFor(int count, Fn fn) const {
+        int n = max(1, min(threadCount, count));
+        vector<thread> workers;
+        for (int t = 0; t < n; t++) {
+            int begin = static_cast<int>(static_cast<long long>(count) * t / n);
+            int end = static_cast<int>(static_cast<long long>(count) * (t + 1) / n);
+            workers.push_back(thread(fn, t, begin, end));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // 同时推进一批对局直到全部结束，样本写入buffer
+    void selfPlay(uint64_t firstSeed, int gameCount, SampleBuffer& buffer) const {
+        vector<SimGame> games;
+        games.reserve(gameCount);
+        for (int i = 0; i < gameCount; i++) {
+            games.push_back(SimGame(firstSeed + i));
+        }
+        vector<vector<int>> playable(gameCount);
+        vector<vector<uint32_t>> seatSamples(gameCount * 4);
+        vector<int> batchStart(gameCount);
+        vector<int> active;
+        for (int i = 0; i < gameCount; i++) {
+            active.push_back(i);
+        }
+
+        SimRng exploreRng(mixHash(firstSeed));
+        FeatureBatch batch;
+        MoveFeatures::Context ctx;
+        float features[MoveFeatures::COUNT];
+        vector<double> probs;
+
+        while (!active.empty()) {
+            // 收集所有进行中对局的候选着法
+            int total = 0;
+            for (int g : active) {
+                games[g].getPlayableCards(games[g].getCurrentPlayer(), playable[g]);
+                total += static_cast<int>(playable[g].size()) + 1;
+            }
+            batch.reset(total);
+            for (int g : active) {
+                MoveFeatures::makeContext(games[g], ctx);
+                batchStart[g] = batch.size();
+                for (int index : playable[g]) {
+                    MoveFeatures::extract(games[g], ctx, index, features);
+                    batch.add(features);
+                }
+                MoveFeatures::extract(games[g], ctx, -1, features);
+                batch.add(features);
+            }
+            const float* scores = batch.score(model);
+
+            for (size_t a = 0; a < active.size();) {
+                int g = active[a];
+                SimGame& game = games[g];
+                int seat = game.getCurrentPlayer();
+                int k = static_cast<int>(playable[g].size()) + 1;
+                const float* s = scores + batchStart[g];
+                int choice = k - 1;
+
+                if (k > 1) {
+                    // softmax采样
+                    probs.resize(k);
+                    double maxScore = s[0];
+                    for (int i = 1; i < k; i++) {
+                        maxScore = max(maxScore, static_cast<double>(s[i]));
+                    }
+                    double sum = 0.0;
+                    for (int i = 0; i < k; i++) {
+                        probs[i] = exp((s[i] - maxScore) / config.temperature);
+                        sum += probs[i];
+                    }
+                    double r = exploreRng.nextDouble() * sum;
+                    for (choice = 0; choice < k - 1 && r >= probs[choice]; choice++) {
+                        r -= probs[choice];
+                    }
+
+                    seatSamples[g * 4 + seat].push_back(static_cast<uint32_t>(buffer.chosen.size()));
+                    buffer.firstRow.push_back(static_cast<uint32_t>(buffer.rows.size() / MoveFeatures::COUNT));
+                    buffer.rowCount.push_back(static_cast<uint8_t>(min(k, 255)));
+                    buffer.chosen.push_back(static_cast<uint8_t>(min(choice, 254)));
+                    buffer.outcome.push_back(0.0f);
+                    for (int i = 0; i < min(k, 255); i++) {
+                        batch.getRow(batchStart[g] + i, features);
+                        buffer.rows.insert(buffer.rows.end(), features, features + MoveFeatures::COUNT);
+                    }
+                }
+
+                // 执行着法，野生牌与电脑一样随机选色
+                int cardIndex = choice < k - 1 ? playable[g][choice] : -1;
+                if (cardIndex < 0 && game.drawCard()) {
+                    cardIndex = static_cast<int>(game.getHand(seat).size()) - 1;
+                }
+                if (cardIndex >= 0) {
+                    UnoCard::Color color = UnoCard::WILD;
+                    if (game.getHand(seat)[cardIndex].isWild()) {
+                        color = static_cast<UnoCard::Color>(game.getRng().nextInt(4));
+                    }
+                    game.playCard(cardIndex, color);
+                }
+
+                if (game.isGameOver()) {
+                    for (int p = 0; p < 4; p++) {
+                        float result = game.getWinner() < 0 ? 0.25f : (game.getWinner() == p ? 1.0f : 0.0f);
+                        for (uint32_t sample : seatSamples[g * 4 + p]) {
+                            buffer.outcome[sample] = result;
+                        }
+                    }
+                    active[a] = active.back();
+                    active.pop_back();
+                }
+                else {
+                    a++;
+                }
+            }
+        }
+    }
+
+    // 策略梯度：Σ (结果 - 基线) * (选中着法的特征 - 当前策略下特征的期望) / 温度
+    void accumulateGradient(const SampleBuffer& buffer, double gradient[MoveFeatures::COUNT]) const {
+        vector<double> probs;
+        for (size_t d = 0; d < buffer.chosen.size(); d++) {
+            const float* rows = buffer.rows.data() + static_cast<size_t>(buffer.firstRow[d]) * MoveFeatures::COUNT;
+            int k = buffer.rowCount[d];
+            probs.resize(k);
+            double maxScore = -1e30;
+            for (int i = 0; i < k; i++) {
+                double score = 0.0;
+                for (int f = 0; f < MoveFeatures::COUNT; f++) {
+                    score += model.weights[f] * rows[i * MoveFeatures::COUNT + f];
+                }
+                probs[i] = score / config.temperature;
+                maxScore = max(maxScore, probs[i]);
+            }
+            double sum = 0.0;
+            for (int i = 0; i < k; i++) {
+                probs[i] = exp(probs[i] - maxScore);
+                sum += probs[i];
+            }
+
+            double advantage = (buffer.outcome[d] - 0.25) / config.temperature;
+            const float* chosenRow = rows + buffer.chosen[d] * MoveFeatures::COUNT;
+            for (int f = 0; f < MoveFeatures::COUNT; f++) {
+                double expected = 0.0;
+                for (int i = 0; i < k; i++) {
+                    expected += probs[i] / sum * rows[i * MoveFeatures::COUNT + f];
+                }
+                gradient[f] += advantage * (chosenRow[f] - expected);
+            }
+        }
+    }
+
+    // 学习模型（座位0、2或1、3）对权重表的得分率
+    double evaluate(uint64_t firstSeed) const {
+        vector<long long> wins(threadCount, 0);
+        parallelFor(config.evalPairs, [this, &wins, firstSeed](int t, int begin, int end) {
+            LearnedPolicy learned(model);
+            HeuristicPolicy heuristic;
+            for (int i = begin; i < end; i++) {
+                for (int rotation = 0; rotation < 2; rotation++) {
+                    vector<UnoPolicy*> seats;
+                    for (int seat = 0; seat < 4; seat++) {
+                        seats.push_back(seat % 2 == rotation ? static_cast<UnoPolicy*>(&learned) : &heuristic);
+                    }
+                    SimGame game(firstSeed + i);
+                    int winner = game.playOut(seats);
+                    if (winner >= 0 && winner % 2 == rotation) {
+                        wins[t]++;
+                    }
+                }
+            }
+        });
+        long long total = 0;
+        for (long long w : wins) {
+            total += w;
+        }
+        return static_cast<double>(total) / (2.0 * config.evalPairs);
+    }
+
+public:
+    explicit SelfPlayTrainer(const Config& c) : config(c) {
+        threadCount = config.threads > 0 ? config.threads : static_cast<int>(max(1u, thread::hardware_concurrency()));
+        model = config.initPath.empty() ? PolicyModel::fromHeuristic(HeuristicWeights()) : PolicyModel::load(config.initPath);
+    }
+
+    void run() {
+        vector<SampleBuffer> buffers(threadCount);
+        uint64_t seed = config.seed;
+        // 评估用的种子与训练种子分开
+        uint64_t evalSeed = mixHash(config.seed) >> 16;
+
+        cout << "初始模型对权重表得分: " << evaluate(evalSeed) * 100.0 << "%" << endl;
+        for (int generation = 1; generation <= config.generations; generation++) {
+            auto start = chrono::steady_clock::now();
+            for (auto& buffer : buffers) {
+                buffer.clear();
+            }
+
+            parallelFor(config.gamesPerGeneration, [this, &buffers, seed](int t, int begin, int end) {
+                for (int g = begin; g < end; g += config.lockstepGames) {
+                    selfPlay(seed + g, min(config.lockstepGames, end - g), buffers[t]);
+                }
+            });
+            seed += config.gamesPerGeneration;
+
+            vector<array<double, MoveFeatures::COUNT>> partial(threadCount);
+            parallelFor(threadCount, [this, &buffers, &partial](int, int begin, int end) {
+                for (int t = begin; t < end; t++) {
+                    partial[t].fill(0.0);
+                    accumulateGradient(buffers[t], partial[t].data());
+                }
+            });
+
+            long long samples = 0;
+            for (const auto& buffer : buffers) {
+                samples += buffer.chosen.size();
+            }
+            for (int f = 0; f < MoveFeatures::COUNT; f++) {
+                double g = 0.0;
+                for (const auto& p : partial) {
+                    g += p[f];
+                }
+                model.weights[f] += static_cast<float>(config.learningRate * g / max(samples, 1LL));
+            }
+            model.save(config.outPath);
+
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cout << "第" << generation << "代: 样本 " << samples << ", 用时 " << seconds << "s, 对权重表得分 "
+                 << evaluate(evalSeed) * 100.0 << "%" << endl;
+        }
+        cout << "模型: " << model.toString() << endl;
+    }
+};
+
+// 命令行：--train [--generations 30] [--games 20000] [--lockstep 256] [--threads 0] [--temperature 1]
+//         [--lr 50] [--eval-pairs 2000] [--seed 1] [--init policy.bin] [--out policy.bin]
+int runTraining(const CommandLine& args) {
+    SelfPlayTrainer::Config config;
+    config.generations = static_cast<int>(args.getInt("--generations", config.generations));
+    config.gamesPerGeneration = static_cast<int>(args.getInt("--games", config.gamesPerGeneration));
+    config.lockstepGames = static_cast<int>(args.getInt("--lockstep", config.lockstepGames));
+    config.threads = static_cast<int>(args.getInt("--threads", config.threads));
+    config.temperature = args.getDouble("--temperature", config.temperature);
+    config.learningRate = args.getDouble("--lr", config.learningRate);
+    config.evalPairs = static_cast<int>(args.getInt("--eval-pairs", config.evalPairs));
+    config.seed = static_cast<uint64_t>(args.getInt("--seed", static_cast<long long>(config.seed)));
+    config.initPath = args.getString("--init", config.initPath);
+    config.outPath = args.getString("--out", config.outPath);
+
+    SelfPlayTrainer trainer(config);
+    trainer.run();
+    return 0;
+}
+
+// 缩小的牌堆：前colors种颜色，每色一张0、1..maxNumber各两张、跳过/反转/+2各一张，
+// 另加wilds张野生牌和wilds张+4
+vector<SimCard> makeReducedDeck(int colors, int maxNumber, int wilds) {
+    vector<SimCard> cards;
+    for (int color = 0; color < colors; color++) {
+        UnoCard::Color c = static_cast<UnoCard::Color>(color);
+        cards.push_back(SimCard(c, UnoCard::NUMBER, 0));
+        for (int num = 1; num <= maxNumber; num++) {
+            cards.push_back(SimCard(c, UnoCard::NUMBER, num));
+            cards.push_back(SimCard(c, UnoCard::NUMBER, num));
+        }
+        cards.push_back(SimCard(c, UnoCard::SKIP));
+        cards.push_back(SimCard(c, UnoCard::REVERSE));
+        cards.push_back(SimCard(c, UnoCard::DRAW_TWO));
+    }
+    for (int i = 0; i < wilds; i++) {
+        cards.push_back(SimCard(UnoCard::WILD, UnoCard::WILD_COLOR));
+        cards.push_back(SimCard(UnoCard::WILD, UnoCard::WILD_DRAW_FOUR));
+    }
+    return cards;
+}
+
+// 穷举固定开局之后d个回合内所有合法的着法序列（类似国际象棋的perft），统计每层节点数
+// 一个回合的着法：打出一张可打的牌（野生牌再分4种颜色）、抽牌后不能打而跳过、
+// 抽牌后保留、抽牌后打出。抽牌总是允许（与玩家按D键一致）
+class PerftCounter {
+public:
+    typedef vector<uint64_t> Counts; // Counts[i]为往下第i层的节点数
+
+private:
+    // 按散列分段加锁的置换表
+    struct CacheShard {
+        mutex lock;
+        unordered_map<uint64_t, pair<uint64_t, Counts>> entries; // 键: 散列1^剩余深度, 值: (散列2, 计数)
+    };
+    static const int CACHE_SHARDS = 64;
+
+    bool useCache;
+    CacheShard cache[CACHE_SHARDS];
+    atomic<uint64_t> cacheHits;
+
+    // 当前玩家一个回合的所有后继局面
+    static void expand(const SimGame& game, vector<SimGame>& children) {
+        children.clear();
+        int seat = game.getCurrentPlayer();
+        vector<int> playable;
+        game.getPlayableCards(seat, playable);
+        for (int index : playable) {
+            addPlays(game, index, children);
+        }
+
+        SimGame drawn = game;
+        if (drawn.drawCard()) {
+            SimGame kept = drawn;
+            kept.keepDrawnCard();
+            children.push_back(kept);
+            addPlays(drawn, static_cast<int>(drawn.getHand(seat).size()) - 1, children);
+        }
+        else {
+            children.push_back(drawn);
+        }
+    }
+
+    static void addPlays(const SimGame& game, int index, vector<SimGame>& children) {
+        bool wild = game.getHand(game.getCurrentPlayer())[index].isWild();
+        for (int color = 0; color < (wild ? 4 : 1); color++) {
+            children.push_back(game);
+            children.back().playCard(index, wild ? static_cast<UnoCard::Color>(color) : UnoCard::WILD);
+        }
+    }
+
+    static void addCounts(Counts& total, const Counts& part, size_t offset) {
+        for (size_t i = 0; i < part.size(); i++) {
+            total[i + offset] += part[i];
+        }
+    }
+
+public:
+    explicit PerftCounter(bool cache) : useCache(cache), cacheHits(0) {}
+
+    // 从game出发往下depth个回合，返回每层节点数（第0层为game自身）
+    Counts count(const SimGame& game, int depth) {
+        Counts counts(depth + 1, 0);
+        counts[0] = 1;
+        if (depth == 0 || game.isGameOver()) {
+            return counts;
+        }
+
+        uint64_t key = 0;
+        uint64_t check = 0;
+        CacheShard* shard = nullptr;
+        if (useCache && depth >= 4) {
+            key = game.hashState(0xCBF29CE484222325ULL) ^ static_cast<uint64_t>(depth);
+            check = game.hashState(0x84222325CBF29CE4ULL);
+            shard = &cache[key % CACHE_SHARDS];
+            lock_guard<mutex> guard(shard->lock);
+            auto it = shard->entries.find(key);
+            if (it != shard->entries.end() && it->second.first == check) {
+                cacheHits++;
+                return it->second.second;
+            }
+        }
+
+        vector<SimGame> children;
+        expand(game, children);
+        if (depth == 1) {
+            counts[1] = children.size();
+        }
+        else {
+            for (const SimGame& child : children) {
+                addCounts(counts, count(child, depth - 1), 1);
+            }
+        }
+
+        if (shard != nullptr) {
+            lock_guard<mutex> guard(shard->lock);
+            shard->entries[key] = make_pair(check, counts);
+        }
+        return counts;
+    }
+
+    // 多线程计数：先展开前两层，再把子树分给各线程
+    Counts countParallel(const SimGame& root, int depth, int threadCount) {
+        if (depth < 3) {
+            return count(root, depth);
+        }
+
+        Counts total(depth + 1, 0);
+        total[0] = 1;
+        vector<SimGame> level1;
+        expand(root, level1);
+        total[1] = level1.size();
+
+        vector<SimGame> tasks;
+        vector<SimGame> children;
+        for (const SimGame& game : level1) {
+            if (game.isGameOver()) {
+                continue;
+            }
+            expand(game, children);
+            tasks.insert(tasks.end(), children.begin(), children.end());
+        }
+
+        atomic<size_t> next(0);
+        vector<Counts> partial(threadCount, Counts(depth + 1, 0));
+        vector<thread> workers;
+        for (int t = 0; t < threadCount; t++) {
+            workers.push_back(thread([this, &tasks, &next, &partial, t, depth]() {
+                for (size_t i = next++; i < tasks.size(); i = next++) {
+                    addCounts(partial[t], count(tasks[i], depth - 2), 2);
+                }
+            }));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (const Counts& part : partial) {
+            addCounts(total, part, 0);
+        }
+        return total;
+    }
+
+    uint64_t getCacheHits() const {
+        return cacheHits;
+    }
+};
+
+// 命令行：--perft [--depth 6] [--players 2] [--hand 3] [--colors 2] [--numbers 3] [--wilds 1]
+//         [--seed 1] [--threads 0] [--no-cache] [--expect 1,12,...]
+// 给出--expect时逐层对比节点数，不一致返回1（用作规则引擎的回归检查）
+// 默认配置深度8的节点数为 1,3,10,40,143,519,1971,7707,31223
+int runPerft(const CommandLine& args) {
+    int depth = static_cast<int>(args.getInt("--depth", 6));
+    int players = static_cast<int>(args.getInt("--players", 2));
+    int handSize = static_cast<int>(args.getInt("--hand", 3));
+    int colors = static_cast<int>(args.getInt("--colors", 2));
+    int numbers = static_cast<int>(args.getInt("--numbers", 3));
+    int wilds = static_cast<int>(args.getInt("--wilds", 1));
+    if (colors < 1 || colors > 4) {
+        throw runtime_error("--colors 应在 1 到 4 之间");
+    }
+    if (numbers < 0 || numbers > 9) {
+        throw runtime_error("--numbers 应在 0 到 9 之间");
+    }
+    if (players < 2 || handSize < 1 || wilds < 0 || depth < 0) {
+        throw runtime_error("--players 应至少为2，--hand 至少为1，--wilds 和 --depth 不能为负");
+    }
+    vector<SimCard> cards = makeReducedDeck(colors, numbers, wilds);
+    uint64_t seed = static_cast<uint64_t>(args.getInt("--seed", 1));
+    int threadCount = static_cast<int>(args.getInt("--threads", 0));
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(max(1u, thread::hardware_concurrency()));
+    }
+    SimGame root(seed, players, handSize, cards);
+    PerftCounter counter(!args.has("--no-cache"));
+    auto start = chrono::steady_clock::now();
+    PerftCounter::Counts counts = counter.countParallel(root, depth, threadCount);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t nodes = 0;
+    for (int d = 0; d <= depth; d++) {
+        cout << "深度 " << d << ": " << counts[d] << endl;
+        nodes += counts[d];
+    }
+    cout << "节点 " << nodes << ", 用时 " << seconds << "s, " << (seconds > 0 ? nodes / seconds : 0.0)
+         << " 节点/秒, 置换表命中 " << counter.getCacheHits() << endl;
+
+    string expected = args.getString("--expect", "");
+    if (!expected.empty()) {
+        stringstream ss(expected);
+        string item;
+        for (int d = 0; getline(ss, item, ','); d++) {
+            if (d > depth || stoull(item) != counts[d]) {
+                cout << "深度 " << d << " 的节点数与预期不符: " << item << endl;
+                return 1;
+            }
+        }
+        cout << "与预期一致" << endl;
+    }
+    return 0;
+}
+
+// 跨平台的套接字封装（只用于本机观战广播）
+#ifdef _WIN32
+typedef SOCKET SocketHandle;
+const SocketHandle INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+const int SEND_FLAGS = 0;
+#else
+typedef int SocketHandle;
+const SocketHandle INVALID_SOCKET_HANDLE = -1;
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#endif
+
+void initSockets() {
+#ifdef _WIN32
+    static bool initialized = false;
+    if (!initialized) {
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+        initialized = true;
+    }
+#endif
+}
+
+void closeSocket(SocketHandle socket) {
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+// 发送全部字节，失败返回false
+bool sendAll(SocketHandle socket, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        int sent = send(socket, reinterpret_cast<const char*>(data), static_cast<int>(size), SEND_FLAGS);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+// 接收恰好size个字节，连接关闭或出错返回false
+bool recvAll(SocketHandle socket, uint8_t* data, size_t size) {
+    while (size > 0) {
+        int received = recv(socket, reinterpret_cast<char*>(data), static_cast<int>(size), 0);
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= received;
+    }
+    return true;
+}
+
+// 观众能看到的牌桌状态：只有各家手牌数，不含手牌内容
+struct TableSnapshot {
+    vector<uint8_t> handSizes;
+    uint8_t topCard = 0;    // SimCard编码，野生牌带所选颜色
+    bool clockwise = true;
+    int currentPlayer = 0;  // 下一个行动的座位（对局结束时为胜者）
+    int deckSize = 0;
+    int cardsPlayed = 0;
+    int winner = -1;
+
+    bool operator==(const TableSnapshot& other) const {
+        return handSizes == other.handSizes && topCard == other.topCard && clockwise == other.clockwise &&
+               currentPlayer == other.currentPlayer && deckSize == other.deckSize &&
+               cardsPlayed == other.cardsPlayed && winner == other.winner;
+    }
+};
+
+TableSnapshot snapshotOf(const SimGame& game) {
+    TableSnapshot snapshot;
+    for (int seat = 0; seat < game.getNumPlayers(); seat++) {
+        snapshot.handSizes.push_back(static_cast<uint8_t>(min<size_t>(game.getHand(seat).size(), 255)));
+    }
+    snapshot.topCard = game.getTopCard().getCode();
+    snapshot.clockwise = game.isClockwise();
+    snapshot.currentPlayer = game.getCurrentPlayer();
+    snapshot.deckSize = game.getDeckSize();
+    snapshot.cardsPlayed = game.getCardsPlayed();
+    snapshot.winner = game.getWinner();
+    return snapshot;
+}
+
+TableSnapshot snapshotOf(const UnoGame& game) {
+    TableSnapshot snapshot;
+    for (const UnoPlayer& player : game.getPlayers()) {
+        snapshot.handSizes.push_back(static_cast<uint8_t>(min<size_t>(player.getHand().size(), 255)));
+    }
+    snapshot.topCard = SimCard::fromUnoCard(game.getTopCard()).getCode();
+    snapshot.clockwise = game.isClockwise();
+    snapshot.currentPlayer = game.getCurrentPlayer();
+    snapshot.deckSize = game.getDeckSize();
+    snapshot.cardsPlayed = game.getCardsPlayed();
+    snapshot.winner = game.isGameOver() ? game.getCurrentPlayer() : -1;
+    return snapshot;
+}
+
+// 观战数据流的编码与解码
+// 帧格式：u32 后续长度, u8 类型, u32 状态序号, 内容
+//   增量帧'D'：u8 标志(1=出了牌, 2=顺时针), [u8 顶牌], u8 当前座位, u8 牌堆张数, u8 胜者, 各座位本回合抽牌数
+//   关键帧'K'：u8 座位数, 各座位手牌数, u8 顶牌, u8 方向, u8 当前座位, u8 牌堆张数, u8 胜者, u32 已出牌数
+// 每个状态发一个增量帧（出牌的座位是上一状态的当前座位），每隔若干状态再附带一个同序号的关键帧，
+// 跟上进度的观众用它核对，新加入或掉帧的观众用它重新同步
+class SpectatorCodec {
+public:
+    typedef shared_ptr<const vector<uint8_t>> Frame;
+
+    static const uint8_t KEYFRAME = 'K';
+    static const uint8_t DELTA = 'D';
+    static const uint8_t NO_WINNER = 0xFF;
+
+private:
+    TableSnapshot last;
+    uint32_t sequence;
+    int keyframeInterval;
+    bool started;
+
+    static void writeHeader(BinaryWriter& writer, uint8_t type, uint32_t seq) {
+        writer.writeU32(0);
+        writer.writeU8(type);
+        writer.writeU32(seq);
+    }
+
+    // 回填长度前缀，转成共享的只读缓冲区
+    static Frame finish(BinaryWriter& writer) {
+        vector<uint8_t>& bytes = writer.getBytes();
+        uint32_t length = static_cast<uint32_t>(bytes.size() - 4);
+        for (int i = 0; i < 4; i++) {
+            bytes[i] = static_cast<uint8_t>(length >> (8 * i));
+        }
+        return make_shared<const vector<uint8_t>>(move(bytes));
+    }
+
+    static uint8_t winnerByte(const TableSnapshot& snapshot) {
+        return snapshot.winner < 0 ? NO_WINNER : static_cast<uint8_t>(snapshot.winner);
+    }
+
+public:
+    explicit SpectatorCodec(int interval = 32) : sequence(0), keyframeInterval(max(interval, 1)), started(false) {}
+
+    // 为新状态编码帧，不需要的帧置空
+    void encode(const TableSnapshot& snapshot, Frame& delta, Frame& keyframe) {
+        delta.reset();
+        keyframe.reset();
+        // 换了牌桌或开了新局时只发关键帧
+        bool sameTable = started && snapshot.handSizes.size() == last.handSizes.size() &&
+                         snapshot.cardsPlayed >= last.cardsPlayed;
+        uint8_t deckSize = static_cast<uint8_t>(min(snapshot.deckSize, 255));
+
+        if (sameTable) {
+            int played = snapshot.cardsPlayed - last.cardsPlayed;
+            BinaryWriter writer;
+            writeHeader(writer, DELTA, sequence);
+            writer.writeU8(static_cast<uint8_t>((played > 0 ? 1 : 0) | (snapshot.clockwise ? 2 : 0)));
+            if (played > 0) {
+                writer.writeU8(snapshot.topCard);
+            }
+            writer.writeU8(static_cast<uint8_t>(snapshot.currentPlayer));
+            writer.writeU8(deckSize);
+            writer.writeU8(winnerByte(snapshot));
+            for (size_t seat = 0; seat < snapshot.handSizes.size(); seat++) {
+                int drawn = snapshot.handSizes[seat] - last.handSizes[seat];
+                if (static_cast<int>(seat) == last.currentPlayer) {
+                    drawn += played;
+                }
+                writer.writeU8(static_cast<uint8_t>(drawn));
+            }
+            delta = finish(writer);
+        }
+
+        if (!sameTable || sequence % keyframeInterval == 0) {
+            BinaryWriter writer;
+            writeHeader(writer, KEYFRAME, sequence);
+            writer.writeU8(static_cast<uint8_t>(snapshot.handSizes.size()));
+            writer.writeBytes(snapshot.handSizes.data(), snapshot.handSizes.size());
+            writer.writeU8(snapshot.topCard);
+            writer.writeU8(snapshot.clockwise ? 1 : 0);
+            writer.writeU8(static_cast<uint8_t>(snapshot.currentPlayer));
+            writer.writeU8(deckSize);
+            writer.writeU8(winnerByte(snapshot));
+            writer.writeU32(static_cast<uint32_t>(snapshot.cardsPlayed));
+            keyframe = finish(writer);
+        }
+
+        last = snapshot;
+        sequence++;
+        started = true;
+    }
+
+    // 读取帧头（不含长度前缀）
+    static void readHeader(const uint8_t* data, size_t size, uint8_t& type, uint32_t& seq) {
+        BinaryReader reader(data, size);
+        type = reader.readU8();
+        seq = reader.readU32();
+    }
+
+    // 关键帧：直接得到完整状态
+    static void applyKeyframe(const uint8_t* data, size_t size, TableSnapshot& state) {
+        BinaryReader reader(data + 5, size - 5);
+        state.handSizes.resize(reader.readU8());
+        reader.readBytes(state.handSizes.data(), state.handSizes.size());
+        state.topCard = reader.readU8();
+        state.clockwise = reader.readU8() != 0;
+        state.currentPlayer = reader.readU8();
+        state.deckSize = reader.readU8();
+        uint8_t winner = reader.readU8();
+        state.winner = winner == NO_WINNER ? -1 : winner;
+        state.cardsPlayed = static_cast<int>(reader.readU32());
+    }
+
+    // 增量帧：在上一状态上更新，drawn返回各座位本回合抽牌数
+    static void applyDelta(const uint8_t* data, size_t size, TableSnapshot& state, vector<uint8_t>& drawn) {
+        BinaryReader reader(data + 5, size - 5);
+        uint8_t flags = reader.readU8();
+        int actor = state.currentPlayer;
+        if (flags & 1) {
+            state.topCard = reader.readU8();
+            state.cardsPlayed++;
+            state.handSizes[actor]--;
+        }
+        state.clockwise = (flags & 2) != 0;
+        state.currentPlayer = reader.readU8();
+        state.deckSize = reader.readU8();
+        uint8_t winner = reader.readU8();
+        state.winner = winner == NO_WINNER ? -1 : winner;
+        drawn.clear();
+        for (size_t seat = 0; seat < state.handSizes.size(); seat++) {
+            drawn.push_back(reader.readU8());
+            state.handSizes[seat] += drawn.back();
+        }
+    }
+};
+
+// 本机TCP观战广播：每一帧只编码一次，所有观众的发送队列共享同一个引用计数的缓冲区
+// 观众太慢、队列积压时丢弃积压的帧，直到下一个关键帧再继续发送
+class SpectatorServer : public UnoGameListener {
+private:
+    struct Subscriber {
+        SocketHandle socket;
+        mutex lock;
+        condition_variable ready;
+        deque<SpectatorCodec::Frame> queue;
+        bool waitingForKeyframe = false;
+        bool closed = false;
+        uint64_t skipped = 0;
+        thread sender;
+    };
+
+    static const size_t MAX_QUEUE = 64;
+
+    SocketHandle listenSocket;
+    atomic<bool> running;
+    thread acceptThread;
+    mutex subscribersLock;
+    vector<unique_ptr<Subscriber>> subscribers;
+    vector<SpectatorCodec::Frame> catchUp; // 最近的关键帧及其后的增量帧，新观众从这里开始
+    SpectatorCodec codec;
+
+    static void sendLoop(Subscriber* sub) {
+        unique_lock<mutex> guard(sub->lock);
+        while (true) {
+            sub->ready.wait(guard, [sub]() { return sub->closed || !sub->queue.empty(); });
+            if (sub->closed) {
+                return;
+            }
+            SpectatorCodec::Frame frame = sub->queue.front();
+            sub->queue.pop_front();
+            guard.unlock();
+            bool ok = sendAll(sub->socket, frame->data(), frame->size());
+            guard.lock();
+            if (!ok) {
+                sub->closed = true;
+                return;
+            }
+        }
+    }
+
+    void acceptLoop() {
+        while (running) {
+            // 用select定时醒来，以便检查是否需要停止
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(listenSocket, &readable);
+            timeval timeout = { 0, 100000 };
+            if (select(static_cast<int>(listenSocket) + 1, &readable, nullptr, nullptr, &timeout) <= 0) {
+                continue;
+            }
+            SocketHandle client = accept(listenSocket, nullptr, nullptr);
+            if (client == INVALID_SOCKET_HANDLE) {
+                continue;
+            }
+
+            unique_ptr<Subscriber> sub(new Subscriber());
+            sub->socket = client;
+            lock_guard<mutex> guard(subscribersLock);
+            sub->queue.assign(catchUp.begin(), catchUp.end());
+            sub->waitingForKeyframe = catchUp.empty();
+            sub->sender = thread(sendLoop, sub.get());
+            subscribers.push_back(move(sub));
+        }
+    }
+
+    static void shutdownSubscriber(Subscriber& sub) {
+        {
+            lock_guard<mutex> guard(sub.lock);
+            sub.closed = true;
+        }
+        sub.ready.notify_one();
+#ifdef _WIN32
+        shutdown(sub.socket, SD_BOTH);
+#else
+        shutdown(sub.socket, SHUT_RDWR);
+#endif
+        sub.sender.join();
+        closeSocket(sub.socket);
+    }
+
+public:
+    explicit SpectatorServer(int keyframeInterval = 32)
+        : listenSocket(INVALID_SOCKET_HANDLE), running(false), codec(keyframeInterval) {}
+
+    ~SpectatorServer() {
+        stop();
+    }
+
+    // 在本机端口上开始监听
+    bool start(int port) {
+        initSockets();
+        listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listenSocket == INVALID_SOCKET_HANDLE) {
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listenSocket, 16) != 0) {
+            closeSocket(listenSocket);
+            listenSocket = INVALID_SOCKET_HANDLE;
+            return false;
+        }
+        running = true;
+        acceptThread = thread(&SpectatorServer::acceptLoop, this);
+        return true;
+    }
+
+    void stop() {
+        if (!running) {
+            return;
+        }
+        running = false;
+        acceptThread.join();
+        closeSocket(listenSocket);
+        for (auto& sub : subscribers) {
+            shutdownSubscriber(*sub);
+        }
+        subscribers.clear();
+    }
+
+    // 编码新的牌桌状态并发给所有观众
+    void publish(const TableSnapshot& snapshot) {
+        SpectatorCodec::Frame delta, keyframe;
+        codec.encode(snapshot, delta, keyframe);
+
+        lock_guard<mutex> guard(subscribersLock);
+        if (keyframe) {
+            catchUp.clear();
+        }
+        if (delta && !catchUp.empty()) {
+            catchUp.push_back(delta);
+        }
+        if (keyframe) {
+            catchUp.push_back(keyframe);
+        }
+
+        for (size_t i = 0; i < subscribers.size();) {
+            Subscriber& sub = *subscribers[i];
+            unique_lock<mutex> subGuard(sub.lock);
+            if (sub.closed) {
+                subGuard.unlock();
+                shutdownSubscriber(sub);
+                subscribers.erase(subscribers.begin() + i);
+                continue;
+            }
+            if (sub.queue.size() >= MAX_QUEUE) {
+                // 观众跟不上，丢掉积压的帧，从下一个关键帧继续
+                sub.skipped += sub.queue.size();
+                sub.queue.clear();
+                sub.waitingForKeyframe = true;
+            }
+            if (delta) {
+                if (sub.waitingForKeyframe) {
+                    sub.skipped++;
+                }
+                else {
+                    sub.queue.push_back(delta);
+                }
+            }
+            if (keyframe) {
+                sub.waitingForKeyframe = false;
+                sub.queue.push_back(keyframe);
+            }
+            sub.ready.notify_one();
+            i++;
+        }
+    }
+
+    void onTurnEnd(const UnoGame& game) override {
+        publish(snapshotOf(game));
+    }
+
+    int getSubscriberCount() {
+        lock_guard<mutex> guard(subscribersLock);
+        return static_cast<int>(subscribers.size());
+    }
+};
+
+// 广播模拟对局（电脑对电脑），用于测试观战
+// 命令行：--broadcast [--port 5555] [--seed 1] [--games 1] [--delay 200] [--keyframe 32] [--wait 1]
+// --wait n 表示等到至少n个观众连上再开始
+int runBroadcast(const CommandLine& args) {
+    SpectatorServer server(static_cast<int>(args.getInt("--keyframe", 32)));
+    int port = static_cast<int>(args.getInt("--port", 5555));
+    if (!server.start(port)) {
+        cout << "无法监听端口 " << port << endl;
+        return 1;
+    }
+    int delay = static_cast<int>(args.getInt("--delay", 200));
+    int games = static_cast<int>(args.getInt("--games", 1));
+    uint64_t seed = static_cast<uint64_t>(args.getInt("--seed", 1));
+    int waitFor = static_cast<int>(args.getInt("--wait", 0));
+    while (server.getSubscriberCount() < waitFor) {
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+
+    HeuristicPolicy policy;
+    for (int g = 0; g < games; g++) {
+        SimGame game(seed + g);
+        server.publish(snapshotOf(game));
+        while (!game.isGameOver()) {
+            game.playTurn(policy);
+            server.publish(snapshotOf(game));
+            this_thread::sleep_for(chrono::milliseconds(delay));
+        }
+        TableSnapshot final = snapshotOf(game);
+        cout << "第" << g + 1 << "局结束, 胜者座位" << final.winner << ", 手牌数:";
+        for (uint8_t size : final.handSizes) {
+            cout << " " << static_cast<int>(size);
+        }
+        cout << endl;
+    }
+    // 给观众留出收完数据的时间
+    this_thread::sleep_for(chrono::milliseconds(500));
+    server.stop();
+    return 0;
+}
+
+// 观战客户端：从数据流重建牌桌，并在每个关键帧核对重建结果
+// 命令行：--watch [--port 5555] [--quiet]
+int runWatch(const CommandLine& args) {
+    initSockets();
+    int port = static_cast<int>(args.getInt("--port", 5555));
+    bool quiet = args.has("--quiet");
+    SocketHandle sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (sock == INVALID_SOCKET_HANDLE || connect(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        cout << "无法连接端口 " << port << endl;
+        return 1;
+    }
+
+    TableSnapshot state;
+    bool hasState = false;
+    uint32_t lastSequence = 0;
+    vector<uint8_t> body;
+    vector<uint8_t> drawn;
+    int deltas = 0;
+    int keyframeChecks = 0;
+    int mismatches = 0;
+    uint8_t header[4];
+
+    while (recvAll(sock, header, 4)) {
+        uint32_t length = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<uint32_t>(header[3]) << 24);
+        body.resize(length);
+        if (!recvAll(sock, body.data(), length)) {
+            break;
+        }
+        uint8_t type;
+        uint32_t sequence;
+        SpectatorCodec::readHeader(body.data(), body.size(), type, sequence);
+
+        if (type == SpectatorCodec::KEYFRAME) {
+            TableSnapshot keyframe;
+            SpectatorCodec::applyKeyframe(body.data(), body.size(), keyframe);
+            if (hasState && sequence == lastSequence) {
+                // 与增量帧重建的结果核对
+                keyframeChecks++;
+                if (!(keyframe == state)) {
+                    mismatches++;
+                }
+            }
+            state = keyframe;
+            hasState = true;
+            lastSequence = sequence;
+        }
+        else {
+            if (!hasState || sequence != lastSequence + 1) {
+                // 漏了帧，等下一个关键帧
+                hasState = false;
+                continue;
+            }
+            TableSnapshot before = state;
+            SpectatorCodec::applyDelta(body.data(), body.size(), state, drawn);
+            lastSequence = sequence;
+            deltas++;
+
+            if (!quiet) {
+                cout << "#" << sequence << " 座位" << before.currentPlayer;
+                if (state.cardsPlayed != before.cardsPlayed) {
+                    cout << " 打出 " << SimCard::fromCode(state.topCard).toString();
+                }
+                for (size_t seat = 0; seat < drawn.size(); seat++) {
+                    if (drawn[seat] > 0) {
+                        cout << " 座位" << seat << "抽" << static_cast<int>(drawn[seat]) << "张";
+                    }
+                }
+                cout << (state.clockwise ? " 顺时针" : " 逆时针") << " 手牌数:";
+                for (uint8_t size : state.handSizes) {
+                    cout << " " << static_cast<int>(size);
+                }
+                cout << endl;
+            }
+            if (state.winner >= 0) {
+                cout << "对局结束, 胜者座位" << state.winner << ", 手牌数:";
+                for (uint8_t size : state.handSizes) {
+                    cout << " " << static_cast<int>(size);
+                }
+                cout << endl;
+            }
+        }
+    }
+    closeSocket(sock);
+    cout << "收到增量帧 " << deltas << ", 关键帧核对 " << keyframeChecks << " 次, 不一致 " << mismatches << " 次" << endl;
+    return mismatches == 0 ? 0 : 1;
+}
+
+// 只读内存映射整个文件
+class MappedFile {
+private:
+    const uint8_t* data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#endif
+
+public:
+    MappedFile() : data(nullptr), size(0) {
+#ifdef _WIN32
+        fileHandle = INVALID_HANDLE_VALUE;
+        mappingHandle = nullptr;
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data != nullptr) {
+            UnmapViewOfFile(data);
+        }
+        if (mappingHandle != nullptr) {
+            CloseHandle(mappingHandle);
+        }
+        if (fileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(fileHandle);
+        }
+#else
+        if (data != nullptr) {
+            munmap(const_cast<uint8_t*>(data), size);
+        }
+#endif
+    }
+
+    void open(const string& path) {
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER fileSize;
+        if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize)) {
+            throw runtime_error("无法打开文件: " + path);
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle != nullptr) {
+            data = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            throw runtime_error("无法打开文件: " + path);
+        }
+        size = static_cast<size_t>(info.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        data = mapped == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(mapped);
+#endif
+        if (data == nullptr) {
+            throw runtime_error("无法映射文件: " + path);
+        }
+    }
+
+    const uint8_t* getData() const {
+        return data;
+    }
+
+    size_t getSize() const {
+        return size;
+    }
+};
+
+// 列式存储文件
+// 每张表按BLOCK_ROWS行分块，每块每列用参照系编码：存 (值 - 块内最小值)，按范围选0/1/2/4字节宽，
+// 同时记录块内最小/最大值用于跳过不可能满足条件的块。所有值都是32位无符号整数
+// 文件结构：u32 魔数, u32 版本, 各列数据块, 目录, u64 目录偏移, u64 目录校验和
+class ColumnFile {
+public:
+    static const uint32_t MAGIC = 0x434F4E55; // "UNOC"
+    static const uint32_t VERSION = 1;
+    static const uint32_t BLOCK_ROWS = 65536;
+
+    struct Chunk {
+        uint64_t offset;
+        uint8_t width;
+        uint32_t minValue;
+        uint32_t maxValue;
+        const uint8_t* data; // 读取时指向映射的内存
+    };
+
+    struct Block {
+        uint32_t rows;
+        vector<Chunk> chunks; // 每列一个
+    };
+
+    struct Table {
+        string name;
+        vector<string> columns;
+        uint64_t rows = 0;
+        vector<Block> blocks;
+        vector<vector<uint32_t>> pending; // 写入时尚未成块的行
+
+        int columnIndex(const string& column) const {
+            for (size_t i = 0; i < columns.size(); i++) {
+                if (columns[i] == column) {
+                    return static_cast<int>(i);
+                }
+            }
+            return -1;
+        }
+    };
+
+    // 把一块编码后的列解码到out
+    static void decode(const Chunk& chunk, uint32_t rows, uint32_t* out) {
+        uint32_t base = chunk.minValue;
+        const uint8_t* p = chunk.data;
+        switch (chunk.width) {
+        case 0:
+            for (uint32_t i = 0; i < rows; i++) {
+                out[i] = base;
+            }
+            break;
+        case 1:
+            for (uint32_t i = 0; i < rows; i++) {
+                out[i] = base + p[i];
+            }
+            break;
+        case 2:
+            for (uint32_t i = 0; i < rows; i++) {
+                out[i] = base + (p[2 * i] | (p[2 * i + 1] << 8));
+            }
+            break;
+        default:
+            for (uint32_t i = 0; i < rows; i++) {
+                out[i] = base + (p[4 * i] | (p[4 * i + 1] << 8) | (p[4 * i + 2] << 16) | (static_cast<uint32_t>(p[4 * i + 3]) << 24));
+            }
+            break;
+        }
+    }
+};
+
+// 流式写入列式文件：每满一块就写出，目录最后写
+class ColumnFileWriter {
+private:
+    ofstream file;
+    uint64_t offset;
+    vector<ColumnFile::Table> tables;
+    vector<uint8_t> encoded;
+
+    void writeRaw(const uint8_t* data, size_t size) {
+        file.write(reinterpret_cast<const char*>(data), size);
+        offset += size;
+    }
+
+    void flushBlock(ColumnFile::Table& table) {
+        uint32_t rows = static_cast<uint32_t>(table.pending.empty() ? 0 : table.pending[0].size());
+        if (rows == 0) {
+            return;
+        }
+        ColumnFile::Block block;
+        block.rows = rows;
+        for (auto& values : table.pending) {
+            ColumnFile::Chunk chunk;
+            chunk.minValue = *min_element(values.begin(), values.end());
+            chunk.maxValue = *max_element(values.begin(), values.end());
+            uint32_t range = chunk.maxValue - chunk.minValue;
+            chunk.width = range == 0 ? 0 : range < 0x100 ? 1 : range < 0x10000 ? 2 : 4;
+            chunk.data = nullptr;
+
+            // 按8字节对齐
+            static const uint8_t zeros[8] = {};
+            writeRaw(zeros, (8 - offset % 8) % 8);
+            chunk.offset = offset;
+
+            encoded.resize(static_cast<size_t>(rows) * chunk.width);
+            for (uint32_t i = 0; i < rows; i++) {
+                uint32_t v = values[i] - chunk.minValue;
+                for (int b = 0; b < chunk.width; b++) {
+                    encoded[i * chunk.width + b] = static_cast<uint8_t>(v >> (8 * b));
+                }
+            }
+            writeRaw(encoded.data(), encoded.size());
+            block.chunks.push_back(chunk);
+            values.clear();
+        }
+        table.blocks.push_back(block);
+    }
+
+public:
+    explicit ColumnFileWriter(const string& path) : file(path, ios::binary), offset(0) {
+        if (!file) {
+            throw runtime_error("无法写入文件: " + path);
+        }
+        BinaryWriter writer;
+        writer.writeU32(ColumnFile::MAGIC);
+        writer.writeU32(ColumnFile::VERSION);
+        writeRaw(writer.getBytes().data(), writer.getBytes().size());
+    }
+
+    // 添加一张表，返回表号
+    int addTable(const string& name, const vector<string>& columns) {
+        ColumnFile::Table table;
+        table.name = name;
+        table.columns = columns;
+        table.pending.resize(columns.size());
+        tables.push_back(table);
+        return static_cast<int>(tables.size()) - 1;
+    }
+
+    // 追加一行，values的个数等于列数
+    void appendRow(int tableIndex, const uint32_t* values) {
+        ColumnFile::Table& table = tables[tableIndex];
+        for (size_t c = 0; c < table.columns.size(); c++) {
+            table.pending[c].push_back(values[c]);
+        }
+        table.rows++;
+        if (table.pending[0].size() == ColumnFile::BLOCK_ROWS) {
+            flushBlock(table);
+        }
+    }
+
+    // 写出剩余的块和目录
+    void close() {
+        for (auto& table : tables) {
+            flushBlock(table);
+        }
+        BinaryWriter dir;
+        dir.writeU32(static_cast<uint32_t>(tables.size()));
+        for (const auto& table : tables) {
+            dir.writeU32(static_cast<uint32_t>(table.name.size()));
+            dir.writeBytes(table.name.data(), table.name.size());
+            dir.writeU64(table.rows);
+            dir.writeU32(static_cast<uint32_t>(table.columns.size()));
+            for (const string& column : table.columns) {
+                dir.writeU32(static_cast<uint32_t>(column.size()));
+                dir.writeBytes(column.data(), column.size());
+            }
+            dir.writeU32(static_cast<uint32_t>(table.blocks.size()));
+            for (const auto& block : table.blocks) {
+                dir.writeU32(block.rows);
+                for (const auto& chunk : block.chunks) {
+                    dir.writeU64(chunk.offset);
+                    dir.writeU8(chunk.width);
+                    dir.writeU32(chunk.minValue);
+                    dir.writeU32(chunk.maxValue);
+                }
+            }
+        }
+        uint64_t dirOffset = offset;
+        writeRaw(dir.getBytes().data(), dir.getBytes().size());
+        BinaryWriter footer;
+        footer.writeU64(dirOffset);
+        footer.writeU64(fnv1a(dir.getBytes().data(), dir.getBytes().size()));
+        writeRaw(footer.getBytes().data(), footer.getBytes().size());
+        file.close();
+    }
+};
+
+// 以内存映射方式打开的列式文件
+class ColumnStore {
+private:
+    MappedFile file;
+    vector<ColumnFile::Table> tables;
+
+public:
+    void open(const string& path) {
+        file.open(path);
+        const uint8_t* data = file.getData();
+        size_t size = file.getSize();
+        if (size < 24) {
+            throw runtime_error("列式文件不完整");
+        }
+        BinaryReader header(data, size);
+        if (header.readU32() != ColumnFile::MAGIC || header.readU32() != ColumnFile::VERSION) {
+            throw runtime_error("不是列式文件或版本不符");
+        }
+        BinaryReader footer(data + size - 16, 16);
+        uint64_t dirOffset = footer.readU64();
+        uint64_t dirChecksum = footer.readU64();
+        if (dirOffset > size - 16 || fnv1a(data + dirOffset, size - 16 - dirOffset) != dirChecksum) {
+            throw runtime_error("列式文件目录损坏");
+        }
+
+        BinaryReader dir(data + dirOffset, size - 16 - dirOffset);
+        tables.resize(dir.readU32());
+        for (auto& table : tables) {
+            table.name.resize(dir.readU32());
+            dir.readBytes(&table.name[0], table.name.size());
+            table.rows = dir.readU64();
+            table.columns.resize(dir.readU32());
+            for (string& column : table.columns) {
+                column.resize(dir.readU32());
+                dir.readBytes(&column[0], column.size());
+            }
+            table.blocks.resize(dir.readU32());
+            for (auto& block : table.blocks) {
+                block.rows = dir.readU32();
+                block.chunks.resize(table.columns.size());
+                for (auto& chunk : block.chunks) {
+                    chunk.offset = dir.readU64();
+                    chunk.width = dir.readU8();
+                    chunk.minValue = dir.readU32();
+                    chunk.maxValue = dir.readU32();
+                    if (chunk.offset + static_cast<uint64_t>(block.rows) * chunk.width > dirOffset) {
+                        throw runtime_error("列式文件数据块越界");
+                    }
+                    chunk.data = data + chunk.offset;
+                }
+            }
+        }
+    }
+
+    const ColumnFile::Table* findTable(const string& name) const {
+        for (const auto& table : tables) {
+            if (table.name == name) {
+                return &table;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// 把模拟对局记录成两张表
+//   games：game 对局号(种子-起始种子), winner 胜者座位(255为平局), turns 回合数, played 打出的牌数
+//   turns：每个回合一行
+//     game, turn 第几回合, seat 座位, hand 行动前手牌数,
+//     holds 行动前手中的牌型(位1:+4, 2:野生, 4:+2, 8:跳过, 16:反转), top 行动前顶牌编码,
+//     card 打出的牌编码, type 打出的牌型(0数字 1跳过 2反转 3+2 4野生 5+4)，没出牌时两者都是255,
+//     drew 本回合自己抽的牌数, won 该座位最终是否获胜, remaining 这一回合之后对局还剩的回合数,
+//     color 打出的牌的颜色(野生牌为选定的颜色，没出牌时为255)
+class GameRecorder {
+public:
+    static const int GAME_COLUMNS = 4;
+    static const int TURN_COLUMNS = 12;
+
+    static vector<string> gameColumns() {
+        return { "game", "winner", "turns", "played" };
+    }
+
+    static vector<string> turnColumns() {
+        return { "game", "turn", "seat", "hand", "holds", "top", "card", "type", "drew", "won", "remaining", "color" };
+    }
+
+    // 手中牌型的位掩码
+    static uint32_t holdsMask(const vector<SimCard>& hand) {
+        uint32_t mask = 0;
+        for (const SimCard& card : hand) {
+            switch (card.getType()) {
+            case UnoCard::WILD_DRAW_FOUR: mask |= 1; break;
+            case UnoCard::WILD_COLOR: mask |= 2; break;
+            case UnoCard::DRAW_TWO: mask |= 4; break;
+            case UnoCard::SKIP: mask |= 8; break;
+            case UnoCard::REVERSE: mask |= 16; break;
+            default: break;
+            }
+        }
+        return mask;
+    }
+
+    // 用给定策略下完一局，行追加到gameRows和turnRows
+    static void record(uint32_t gameId, SimGame& game, UnoPolicy& policy, vector<uint32_t>& gameRows, vector<uint32_t>& turnRows) {
+        size_t firstTurn = turnRows.size();
+        while (!game.isGameOver()) {
+            int seat = game.getCurrentPlayer();
+            const vector<SimCard>& hand = game.getHand(seat);
+            uint32_t handBefore = static_cast<uint32_t>(hand.size());
+            uint32_t holds = holdsMask(hand);
+            uint32_t top = game.getTopCard().getCode();
+            int playedBefore = game.getCardsPlayed();
+            uint32_t turn = static_cast<uint32_t>(game.getTurnCount());
+
+            game.playTurn(policy);
+
+            bool played = game.getCardsPlayed() > playedBefore;
+            uint32_t card = played ? game.getTopCard().getCode() : 255;
+            uint32_t type = played ? static_cast<uint32_t>(game.getTopCard().getType()) : 255;
+            uint32_t color = played ? static_cast<uint32_t>(game.getTopCard().getColor()) : 255;
+            uint32_t drew = static_cast<uint32_t>(game.getHand(seat).size()) + (played ? 1 : 0) - handBefore;
+            uint32_t row[TURN_COLUMNS] = { gameId, turn, static_cast<uint32_t>(seat), handBefore, holds, top,
+                                           card, type, drew, 0, 0, color };
+            turnRows.insert(turnRows.end(), row, row + TURN_COLUMNS);
+        }
+
+        // 对局结束后补上胜负和剩余回合数
+        uint32_t turns = static_cast<uint32_t>(game.getTurnCount());
+        for (size_t r = firstTurn; r < turnRows.size(); r += TURN_COLUMNS) {
+            turnRows[r + 9] = static_cast<int>(turnRows[r + 2]) == game.getWinner() ? 1 : 0;
+            turnRows[r + 10] = turns - turnRows[r + 1] - 1;
+        }
+        uint32_t gameRow[GAME_COLUMNS] = { gameId, game.getWinner() < 0 ? 255u : static_cast<uint32_t>(game.getWinner()),
+                                           turns, static_cast<uint32_t>(game.getCardsPlayed()) };
+        gameRows.insert(gameRows.end(), gameRow, gameRow + GAME_COLUMNS);
+    }
+};
+
+// 命令行：--record --seeds 0:100000 [--out games.ucs] [--threads 0]
+int runRecord(const CommandLine& args) {
+    uint64_t seedBegin, seedEnd;
+    parseSeedRange(args.getString("--seeds", "0:100000"), seedBegin, seedEnd);
+    string outPath = args.getString("--out", "games.ucs");
+    int threadCount = static_cast<int>(args.getInt("--threads", 0));
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(max(1u, thread::hardware_concurrency()));
+    }
+
+    ColumnFileWriter writer(outPath);
+    int gamesTable = writer.addTable("games", GameRecorder::gameColumns());
+    int turnsTable = writer.addTable("turns", GameRecorder::turnColumns());
+
+    // 每轮每个线程模拟一段连续的种子，再按种子顺序写出，保证文件内容与线程数无关
+    const uint64_t gamesPerThread = 2048;
+    vector<vector<uint32_t>> gameRows(threadCount);
+    vector<vector<uint32_t>> turnRows(threadCount);
+    for (uint64_t roundBegin = seedBegin; roundBegin < seedEnd; roundBegin += gamesPerThread * threadCount) {
+        vector<thread> workers;
+        for (int t = 0; t < threadCount; t++) {
+            workers.push_back(thread([&, t]() {
+                gameRows[t].clear();
+                turnRows[t].clear();
+                HeuristicPolicy policy;
+                uint64_t begin = min(seedEnd, roundBegin + gamesPerThread * t);
+                uint64_t end = min(seedEnd, begin + gamesPerThread);
+                for (uint64_t seed = begin; seed < end; seed++) {
+                    SimGame game(seed);
+                    GameRecorder::record(static_cast<uint32_t>(seed - seedBegin), game, policy, gameRows[t], turnRows[t]);
+                }
+            }));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (int t = 0; t < threadCount; t++) {
+            for (size_t r = 0; r < gameRows[t].size(); r += GameRecorder::GAME_COLUMNS) {
+                writer.appendRow(gamesTable, &gameRows[t][r]);
+            }
+            for (size_t r = 0; r < turnRows[t].size(); r += GameRecorder::TURN_COLUMNS) {
+                writer.appendRow(turnsTable, &turnRows[t][r]);
+            }
+        }
+    }
+    writer.close();
+    cout << "已记录 " << seedEnd - seedBegin << " 局到 " << outPath << endl;
+    return 0;
+}
+
+// 列式文件上的过滤与分组聚合，按块并行扫描
+class ColumnQuery {
+public:
+    struct Filter {
+        int column;
+        string op; // = != < <= > >= &（按位与非零）
+        uint32_t value;
+    };
+
+private:
+    const ColumnFile::Table& table;
+    vector<Filter> filters;
+    int groupColumn;             // -1表示不分组
+    vector<int> avgColumns;
+
+    // 分组累加量：counts[g]以及每个平均列的sums[a][g]
+    struct Accumulator {
+        vector<uint64_t> counts;
+        vector<vector<uint64_t>> sums;
+    };
+
+    // 块内最小/最大值说明这一块不可能满足条件
+    static bool canSkip(const Filter& f, const ColumnFile::Chunk& chunk) {
+        if (f.op == "=") return f.value < chunk.minValue || f.value > chunk.maxValue;
+        if (f.op == "!=") return chunk.minValue == f.value && chunk.maxValue == f.value;
+        if (f.op == "<") return chunk.minValue >= f.value;
+        if (f.op == "<=") return chunk.minValue > f.value;
+        if (f.op == ">") return chunk.maxValue <= f.value;
+        if (f.op == ">=") return chunk.maxValue < f.value;
+        if (f.op == "&") return f.value == 0 || chunk.maxValue < (f.value & (~f.value + 1));
+        return false;
+    }
+
+    // mask[i] &= (values[i] op value)，各分支都是可以自动向量化的简单循环
+    static void applyFilter(const Filter& f, const uint32_t* values, uint32_t rows, uint8_t* mask) {
+        uint32_t v = f.value;
+        if (f.op == "=") for (uint32_t i = 0; i < rows; i++) mask[i] &= values[i] == v;
+        else if (f.op == "!=") for (uint32_t i = 0; i < rows; i++) mask[i] &= values[i] != v;
+        else if (f.op == "<") for (uint32_t i = 0; i < rows; i++) mask[i] &= values[i] < v;
+        else if (f.op == "<=") for (uint32_t i = 0; i < rows; i++) mask[i] &= values[i] <= v;
+        else if (f.op == ">") for (uint32_t i = 0; i < rows; i++) mask[i] &= values[i] > v;
+        else if (f.op == ">=") for (uint32_t i = 0; i < rows; i++) mask[i] &= values[i] >= v;
+        else if (f.op == "&") for (uint32_t i = 0; i < rows; i++) mask[i] &= (values[i] & v) != 0;
+    }
+
+    void scanBlock(const ColumnFile::Block& block, vector<uint32_t>& values, vector<uint8_t>& mask,
+                   vector<uint32_t>& groups, Accumulator& acc) const {
+        for (const Filter& f : filters) {
+            if (canSkip(f, block.chunks[f.column])) {
+                return;
+            }
+        }
+
+        uint32_t rows = block.rows;
+        mask.assign(rows, 1);
+        for (const Filter& f : filters) {
+            ColumnFile::decode(block.chunks[f.column], rows, values.data());
+            applyFilter(f, values.data(), rows, mask.data());
+        }
+
+        if (groupColumn < 0) {
+            groups.assign(rows, 0);
+        }
+        else {
+            ColumnFile::decode(block.chunks[groupColumn], rows, groups.data());
+        }
+        size_t groupCount = groupColumn < 0 ? 1 : block.chunks[groupColumn].maxValue + 1;
+        if (acc.counts.size() < groupCount) {
+            acc.counts.resize(groupCount, 0);
+            for (auto& sum : acc.sums) {
+                sum.resize(groupCount, 0);
+            }
+        }
+
+        for (uint32_t i = 0; i < rows; i++) {
+            acc.counts[groups[i]] += mask[i];
+        }
+        for (size_t a = 0; a < avgColumns.size(); a++) {
+            ColumnFile::decode(block.chunks[avgColumns[a]], rows, values.data());
+            uint64_t* sum = acc.sums[a].data();
+            for (uint32_t i = 0; i < rows; i++) {
+                sum[groups[i]] += static_cast<uint64_t>(values[i]) * mask[i];
+            }
+        }
+    }
+
+public:
+    ColumnQuery(const ColumnFile::Table& t, const vector<Filter>& f, int group, const vector<int>& avg)
+        : table(t), filters(f), groupColumn(group), avgColumns(avg) {}
+
+    // 解析"hand=2,holds&1"形式的条件
+    static vector<Filter> parseFilters(const ColumnFile::Table& table, const string& text) {
+        vector<Filter> result;
+        stringstream ss(text);
+        string item;
+        while (getline(ss, item, ',')) {
+            if (item.empty()) {
+                continue;
+            }
+            size_t pos = item.find_first_of("=!<>&");
+            if (pos == string::npos) {
+                throw runtime_error("无法解析条件: " + item);
+            }
+            size_t valuePos = item.find_first_not_of("=!<>&", pos);
+            Filter f;
+            f.column = table.columnIndex(item.substr(0, pos));
+            f.op = item.substr(pos, valuePos == string::npos ? string::npos : valuePos - pos);
+            static const char* const ops[] = { "=", "!=", "<", "<=", ">", ">=", "&" };
+            if (find(begin(ops), end(ops), f.op) == end(ops)) {
+                throw runtime_error("不支持的运算符 " + f.op + "（可用 = != < <= > >= &）: " + item);
+            }
+            if (f.column < 0) {
+                throw runtime_error("没有这一列: " + item.substr(0, pos));
+            }
+            string value = valuePos == string::npos ? "" : item.substr(valuePos);
+            // 值必须是32位无符号整数，超出范围不能截断
+            bool valid = !value.empty() && value.find_first_not_of("0123456789") == string::npos;
+            string digits = valid ? value.substr(min(value.find_first_not_of('0'), value.size() - 1)) : "";
+            if (!valid || digits.size() > 10 || stoull(digits) > UINT32_MAX) {
+                throw runtime_error("条件的值应为非负整数: " + item);
+            }
+            f.value = static_cast<uint32_t>(stoull(digits));
+            result.push_back(f);
+        }
+        return result;
+    }
+
+    // 并行执行查询并打印每个分组的行数和平均值
+    void run(int threadCount) const {
+        if (groupColumn >= 0) {
+            for (const auto& block : table.blocks) {
+                if (block.chunks[groupColumn].maxValue >= (1u << 20)) {
+                    throw runtime_error("分组列的取值太大");
+                }
+            }
+        }
+
+        vector<Accumulator> partial(threadCount);
+        atomic<size_t> nextBlock(0);
+        vector<thread> workers;
+        for (int t = 0; t < threadCount; t++) {
+            partial[t].sums.resize(avgColumns.size());
+            workers.push_back(thread([this, &partial, &nextBlock, t]() {
+                vector<uint32_t> values(ColumnFile::BLOCK_ROWS);
+                vector<uint32_t> groups(ColumnFile::BLOCK_ROWS);
+                vector<uint8_t> mask;
+                for (size_t b = nextBlock++; b < table.blocks.size(); b = nextBlock++) {
+                    scanBlock(table.blocks[b], values, mask, groups, partial[t]);
+                }
+            }));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        Accumulator total;
+        total.sums.resize(avgColumns.size());
+        for (const auto& acc : partial) {
+            if (total.counts.size() < acc.counts.size()) {
+                total.counts.resize(acc.counts.size(), 0);
+                for (auto& sum : total.sums) {
+                    sum.resize(acc.counts.size(), 0);
+                }
+            }
+            for (size_t g = 0; g < acc.counts.size(); g++) {
+                total.counts[g] += acc.counts[g];
+                for (size_t a = 0; a < avgColumns.size(); a++) {
+                    total.sums[a][g] += acc.sums[a][g];
+                }
+            }
+        }
+
+        cout << (groupColumn >= 0 ? table.columns[groupColumn] : "all") << "\tcount";
+        for (int column : avgColumns) {
+            cout << "\tavg(" << table.columns[column] << ")";
+        }
+        cout << endl;
+        for (size_t g = 0; g < total.counts.size(); g++) {
+            if (total.counts[g] == 0) {
+                continue;
+            }
+            cout << (groupColumn >= 0 ? to_string(g) : "*") << "\t" << total.counts[g];
+            for (size_t a = 0; a < avgColumns.size(); a++) {
+                cout << "\t" << static_cast<double>(total.sums[a][g]) / total.counts[g];
+            }
+            cout << endl;
+        }
+    }
+};
+
+// 命令行：--query games.ucs [--table turns] [--where "hand=2,holds&1"] [--group seat] [--avg won,remaining] [--threads 0]
+// 条件之间是“并且”，运算符为 = != < <= > >= &（按位与非零），条件含<>&时要加引号
+// 例：持有+4且只剩2张牌时的胜率      --where "hand=2,holds&1" --avg won
+//     打出反转之后平均还有多少回合    --where "type=2" --avg remaining
+int runQuery(const CommandLine& args) {
+    ColumnStore store;
+    store.open(args.getString("--query", "games.ucs"));
+    string tableName = args.getString("--table", "turns");
+    const ColumnFile::Table* table = store.findTable(tableName);
+    if (table == nullptr) {
+        cout << "没有这张表: " << tableName << endl;
+        return 1;
+    }
+
+    vector<ColumnQuery::Filter> filters = ColumnQuery::parseFilters(*table, args.getString("--where", ""));
+    int groupColumn = -1;
+    if (args.has("--group")) {
+        groupColumn = table->columnIndex(args.getString("--group", ""));
+        if (groupColumn < 0) {
+            cout << "没有这一列: " << args.getString("--group", "") << endl;
+            return 1;
+        }
+    }
+    vector<int> avgColumns;
+    stringstream ss(args.getString("--avg", ""));
+    string column;
+    while (getline(ss, column, ',')) {
+        int index = table->columnIndex(column);
+        if (index < 0) {
+            cout << "没有这一列: " << column << endl;
+            return 1;
+        }
+        avgColumns.push_back(index);
+    }
+    int threadCount = static_cast<int>(args.getInt("--threads", 0));
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(max(1u, thread::hardware_concurrency()));
+    }
+
+    auto start = chrono::steady_clock::now();
+    ColumnQuery query(*table, filters, groupColumn, avgColumns);
+    query.run(threadCount);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "扫描 " << table->rows << " 行, 用时 " << seconds << "s" << endl;
+    return 0;
+}
+
+// 对玩家回合的确定化模拟：按公开信息（自己的手牌、弃牌堆、各家手牌数）随机分配看不到的牌，
+// 在同一个确定化局面上分别试打每张可打的牌和抽牌，之后所有座位按computerTurn的权重下完，
+// 统计玩家获胜的比例。多个后台线程一直模拟到被取消或达到次数上限
+class MoveQualityAdvisor : public UnoMoveAdvisor {
+public:
+    static const int MAX_SAMPLES = 20000; // 每个选择最多模拟的局数
+
+private:
+    // 分析开始时从UnoGame复制的局面，线程只读
+    struct Position {
+        int seat = 0;
+        bool clockwise = true;
+        vector<SimCard> hand;
+        vector<SimCard> discard;     // 最后一张为顶牌
+        vector<SimCard> unseen;      // 对手手中和牌堆里的牌
+        vector<int> handSizes;
+        vector<int> candidates;      // 可打的牌的索引，最后一项-1表示抽牌
+    };
+
+    int threadCount;
+    Position position;
+    vector<thread> workers;
+    atomic<bool> cancelled;
+    mutable mutex statsMutex;
+    vector<uint64_t> wins;  // 按候选着法
+    int samples;
+
+    // 打出野生牌时选手中剩下最多的颜色
+    static UnoCard::Color preferredColor(const vector<SimCard>& hand, int skipIndex) {
+        int counts[4] = {};
+        for (size_t i = 0; i < hand.size(); i++) {
+            if (static_cast<int>(i) != skipIndex && !hand[i].isWild()) {
+                counts[hand[i].getColor()]++;
+            }
+        }
+        return static_cast<UnoCard::Color>(max_element(counts, counts + 4) - counts);
+    }
+
+    // 在确定化局面上试一个着法并下完，返回玩家是否获胜
+    bool rollout(SimGame game, int candidate, UnoPolicy& policy) const {
+        int seat = position.seat;
+        if (candidate < 0) {
+            // 抽牌，抽到可打的牌就打出
+            candidate = game.drawCard() ? static_cast<int>(game.getHand(seat).size()) - 1 : -1;
+        }
+        if (candidate >= 0) {
+            const vector<SimCard>& hand = game.getHand(seat);
+            UnoCard::Color color = hand[candidate].isWild() ? preferredColor(hand, candidate) : UnoCard::WILD;
+            game.playCard(candidate, color);
+        }
+        while (!game.isGameOver() && !cancelled) {
+            game.playTurn(policy);
+        }
+        return game.getWinner() == seat;
+    }
+
+    void work(uint64_t seed) {
+        SimRng rng(seed);
+        HeuristicPolicy policy;
+        size_t count = position.candidates.size();
+        vector<uint64_t> localWins(count);
+        vector<vector<SimCard>> hands(position.handSizes.size());
+        vector<SimCard> pool;
+
+        while (!cancelled) {
+            // 随机分配看不到的牌，剩下的作为牌堆
+            pool = position.unseen;
+            for (int i = static_cast<int>(pool.size()) - 1; i > 0; i--) {
+                swap(pool[i], pool[rng.nextInt(i + 1)]);
+            }
+            for (size_t seat = 0; seat < hands.size(); seat++) {
+                if (static_cast<int>(seat) == position.seat) {
+                    hands[seat] = position.hand;
+                    continue;
+                }
+                hands[seat].assign(pool.end() - position.handSizes[seat], pool.end());
+                pool.resize(pool.size() - position.handSizes[seat]);
+            }
+            SimGame base(rng.next(), hands, pool, position.discard, position.seat, position.clockwise);
+
+            // 所有候选着法使用同一个确定化局面和随机数，减小比较的方差
+            for (size_t c = 0; c < count; c++) {
+                localWins[c] = rollout(base, position.candidates[c], policy) ? 1 : 0;
+            }
+            if (cancelled) {
+                break;
+            }
+
+            lock_guard<mutex> lock(statsMutex);
+            if (samples >= MAX_SAMPLES) {
+                break;
+            }
+            for (size_t c = 0; c < count; c++) {
+                wins[c] += localWins[c];
+            }
+            samples++;
+        }
+    }
+
+public:
+    // threadCount <= 0 时使用全部硬件线程
+    explicit MoveQualityAdvisor(int threads) : threadCount(threads), cancelled(true), samples(0) {
+        if (threadCount <= 0) {
+            threadCount = static_cast<int>(max(1u, thread::hardware_concurrency()));
+        }
+    }
+
+    ~MoveQualityAdvisor() {
+        stopAnalysis();
+    }
+
+    void startAnalysis(const UnoGame& game) override {
+        stopAnalysis();
+
+        position = Position();
+        position.seat = game.getCurrentPlayer();
+        position.clockwise = game.isClockwise();
+        int seen[BeliefTracker::KINDS] = {};
+
+        for (const UnoCard& card : game.getPlayers()[position.seat].getHand()) {
+            position.hand.push_back(SimCard::fromUnoCard(card));
+            seen[BeliefTracker::kindOf(position.hand.back())]++;
+        }
+        queue<UnoCard> pile = game.getDiscardPile();
+        while (!pile.empty()) {
+            position.discard.push_back(SimCard::fromUnoCard(pile.front()));
+            seen[BeliefTracker::kindOf(position.discard.back())]++;
+            pile.pop();
+        }
+        for (const SimCard& card : SimGame::standardDeck()) {
+            if (seen[card.getCode()] > 0) {
+                seen[card.getCode()]--;
+            }
+            else {
+                position.unseen.push_back(card);
+            }
+        }
+        for (const UnoPlayer& player : game.getPlayers()) {
+            position.handSizes.push_back(static_cast<int>(player.getHand().size()));
+        }
+
+        // 对手手牌数之和加牌堆张数应等于看不到的牌数，否则局面不一致，不做分析
+        int hidden = game.getDeckSize();
+        for (size_t seat = 0; seat < position.handSizes.size(); seat++) {
+            if (static_cast<int>(seat) != position.seat) {
+                hidden += position.handSizes[seat];
+            }
+        }
+        if (hidden != static_cast<int>(position.unseen.size())) {
+            return;
+        }
+
+        for (size_t i = 0; i < position.hand.size(); i++) {
+            if (position.hand[i].canBePlacedOn(position.discard.back())) {
+                position.candidates.push_back(static_cast<int>(i));
+            }
+        }
+        position.candidates.push_back(-1);
+
+        wins.assign(position.candidates.size(), 0);
+        samples = 0;
+        cancelled = false;
+        uint64_t seed = static_cast<uint64_t>(chrono::steady_clock::now().time_since_epoch().count());
+        for (int t = 0; t < threadCount; t++) {
+            workers.push_back(thread(&MoveQualityAdvisor::work, this, mixHash(seed + static_cast<uint64_t>(t))));
+        }
+    }
+
+    void stopAnalysis() override {
+        cancelled = true;
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        lock_guard<mutex> lock(statsMutex);
+        samples = 0;
+    }
+
+    int getEstimates(vector<double>& winRates) const override {
+        lock_guard<mutex> lock(statsMutex);
+        winRates.assign(position.hand.size() + 1, -1.0);
+        if (samples == 0) {
+            return 0;
+        }
+        for (size_t c = 0; c < position.candidates.size(); c++) {
+            int candidate = position.candidates[c];
+            size_t index = candidate < 0 ? position.hand.size() : static_cast<size_t>(candidate);
+            winRates[index] = static_cast<double>(wins[c]) / samples;
+        }
+        return samples;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    CommandLine args(argc, argv);
+
+    // 参数或文件有误时输出原因并返回1
+    int spectatePort = 0;
+    int adviseThreads = 0;
+    double beliefWeight = 0.0;
+    try {
+        // 批量模拟模式（无界面）
+        if (args.has("--ab")) {
+            return runAbTest(args);
+        }
+        if (args.has("--tournament")) {
+            return runTournament(args);
+        }
+        if (args.has("--shard")) {
+            return runShard(args);
+        }
+        if (args.has("--merge")) {
+            return runMerge(args);
+        }
+        if (args.has("--train")) {
+            return runTraining(args);
+        }
+        if (args.has("--perft")) {
+            return runPerft(args);
+        }
+        if (args.has("--broadcast")) {
+            return runBroadcast(args);
+        }
+        if (args.has("--watch")) {
+            return runWatch(args);
+        }
+        if (args.has("--record")) {
+            return runRecord(args);
+        }
+        if (args.has("--query")) {
+            return runQuery(args);
+        }
+
+        spectatePort = static_cast<int>(args.getInt("--spectate-port", 5555));
+        adviseThreads = static_cast<int>(args.getInt("--advise-threads", 0));
+        beliefWeight = args.getDouble("--belief", BeliefComputerBrain::DEFAULT_BELIEF_WEIGHT);
+    }
+    catch (const exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    // 创建游戏对象
+    UnoGame game;
+
+    // 可选的观战广播：--spectate-port 5555
+    SpectatorServer spectators;
+    if (args.has("--spectate-port")) {
+        if (spectators.start(spectatePort)) {
+            game.setListener(&spectators);
+        }
+        else {
+            cout << "无法监听观战端口 " << spectatePort << endl;
+        }
+    }
+
+    // 电脑玩家根据已见的出牌和抽牌推测对手手牌：--belief 1（为0时只按权重出牌、随机选色）
+    BeliefComputerBrain brain(HeuristicWeights(), beliefWeight);
+    if (beliefWeight > 0.0) {
+        game.setComputerBrain(&brain);
+    }
+
+    // 可选的出牌参考：--advise [--advise-threads 0]
+    MoveQualityAdvisor advisor(adviseThreads);
+    if (args.has("--advise")) {
+        game.setAdvisor(&advisor);
+    }
 
     // 运行游戏
     game.run();